@@ -0,0 +1,482 @@
+#include "linked_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Benchmarks the List handle, whose nodes come from the pool, against a
+// plain array and against the same list algorithms with nodes from malloc.
+
+// Operations that do O(1) work per call run this many times at most.
+#define BENCH_FAST_OPS 100000
+// Operations that walk the list or move array elements are given about this
+// many node visits or element moves in total, within the bounds below.
+#define BENCH_WALK_BUDGET 200000000
+#define BENCH_WALK_OPS_MIN 10
+#define BENCH_WALK_OPS_MAX 1000
+
+enum
+{
+    BENCH_INSERT,
+    BENCH_TRAVERSE,
+    BENCH_SEARCH,
+    BENCH_INSERT_AFTER,
+    BENCH_INSERT_BEFORE,
+    BENCH_DELETE,
+    BENCH_OPS
+};
+
+static const char *benchOpNames[BENCH_OPS] = {"insert", "traverse", "search", "insert_after", "insert_before", "delete"};
+
+enum
+{
+    BENCH_ARRAY,
+    BENCH_POOL,
+    BENCH_MALLOC,
+    BENCH_IMPLS
+};
+
+// Time and cache misses of one operation, per call.
+typedef struct BenchResult
+{
+    double ns;
+    double misses;  // negative when the counter is not available
+} BenchResult;
+
+// Inputs shared by all implementations for one list size.
+typedef struct BenchInput
+{
+    size_t n;
+    const uint16_t *values;   // initial contents
+    const size_t *positions;  // positions of the nodes the insert ops use
+    const uint16_t *keys;     // values to search for and delete
+    size_t fastOps;
+    size_t walkOps;
+} BenchInput;
+
+static int missCounter = -1;
+static volatile uint64_t benchSink;  // keeps results of timed loops alive
+
+// Timer and cache miss counter around a timed section.
+typedef struct BenchProbe
+{
+    struct timespec begin;
+} BenchProbe;
+
+/// @brief opens a counter of the cache misses of this process in user space
+/// @return the counter, or -1 if perf events are not available
+static int bench_open_counter()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/// @brief starts timing and counting
+/// @param probe
+static void bench_begin(BenchProbe *probe)
+{
+    if (missCounter >= 0)
+    {
+        ioctl(missCounter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(missCounter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &probe->begin);
+}
+
+/// @brief stops timing and counting
+/// @param probe
+/// @param ops the number of operations in the timed section
+/// @return the cost per operation
+static BenchResult bench_end(BenchProbe *probe, size_t ops)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    BenchResult result = {-1, -1};
+    if (missCounter >= 0)
+    {
+        uint64_t misses;
+        ioctl(missCounter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(missCounter, &misses, sizeof(misses)) == sizeof(misses))
+            result.misses = (double)misses / ops;
+    }
+    result.ns = ((now.tv_sec - probe->begin.tv_sec) * 1e9 + (now.tv_nsec - probe->begin.tv_nsec)) / ops;
+    return result;
+}
+
+// ********* Plain array *********
+
+/// @brief runs all operations on a growable array of values
+/// @param input
+/// @param results
+static void bench_array(const BenchInput *input, BenchResult *results)
+{
+    BenchProbe probe;
+    size_t n = input->n, capacity = 16, count = 0;
+    uint16_t *array = malloc(capacity * sizeof(uint16_t));
+    my_assert(array != NULL);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (count == capacity)
+        {
+            capacity *= 2;
+            array = realloc(array, capacity * sizeof(uint16_t));
+            my_assert(array != NULL);
+        }
+        array[count++] = input->values[i];
+    }
+    results[BENCH_INSERT] = bench_end(&probe, n);
+
+    uint64_t sum = 0;
+    bench_begin(&probe);
+    for (size_t i = 0; i < count; i++)
+        sum += array[i];
+    results[BENCH_TRAVERSE] = bench_end(&probe, n);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+    {
+        size_t j = 0;
+        while (j < count && array[j] != input->keys[i])
+            j++;
+        sum += j;
+    }
+    results[BENCH_SEARCH] = bench_end(&probe, input->walkOps);
+
+    // Inserting in the middle moves the rest of the array either way
+    array = realloc(array, (count + 2 * input->walkOps) * sizeof(uint16_t));
+    my_assert(array != NULL);
+    for (int op = BENCH_INSERT_AFTER; op <= BENCH_INSERT_BEFORE; op++)
+    {
+        bench_begin(&probe);
+        for (size_t i = 0; i < input->walkOps; i++)
+        {
+            size_t at = input->positions[i] + (op == BENCH_INSERT_AFTER);
+            memmove(array + at + 1, array + at, (count - at) * sizeof(uint16_t));
+            array[at] = input->values[i];
+            count++;
+        }
+        results[op] = bench_end(&probe, input->walkOps);
+    }
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+    {
+        size_t j = 0;
+        while (j < count && array[j] != input->keys[i])
+            j++;
+        if (j < count)
+        {
+            memmove(array + j, array + j + 1, (count - j - 1) * sizeof(uint16_t));
+            count--;
+        }
+    }
+    results[BENCH_DELETE] = bench_end(&probe, input->walkOps);
+    benchSink = sum;
+    free(array);
+}
+
+// ********* List on the pool *********
+
+/// @brief runs all operations on a List handle
+/// @param input
+/// @param results
+static void bench_pool(const BenchInput *input, BenchResult *results)
+{
+    BenchProbe probe;
+    size_t n = input->n;
+    List list;
+    list_create(&list, sizeof(Node) * (n + input->fastOps + input->walkOps));
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < n; i++)
+        list_append(&list, input->values[i]);
+    results[BENCH_INSERT] = bench_end(&probe, n);
+    my_assert(list_length(&list) == n);
+
+    uint64_t sum = 0;
+    bench_begin(&probe);
+    for (Node *current = list.head; current != NULL; current = current->next)
+        sum += current->data;
+    results[BENCH_TRAVERSE] = bench_end(&probe, n);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+        sum += (uintptr_t)list_find(&list, input->keys[i]);
+    results[BENCH_SEARCH] = bench_end(&probe, input->walkOps);
+
+    Node **nodes = malloc(n * sizeof(Node *));
+    my_assert(nodes != NULL);
+    size_t j = 0;
+    for (Node *current = list.head; current != NULL; current = current->next)
+        nodes[j++] = current;
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->fastOps; i++)
+        list_add_after(&list, nodes[input->positions[i]], input->values[i]);
+    results[BENCH_INSERT_AFTER] = bench_end(&probe, input->fastOps);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+        list_add_before(&list, nodes[input->positions[i]], input->values[i]);
+    results[BENCH_INSERT_BEFORE] = bench_end(&probe, input->walkOps);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+        list_remove(&list, input->keys[i]);
+    results[BENCH_DELETE] = bench_end(&probe, input->walkOps);
+    benchSink = sum;
+    free(nodes);
+    list_destroy(&list);
+}
+
+// ********* The same list on malloc *********
+
+// List handle whose nodes come from malloc, with the algorithms of List.
+typedef struct MallocList
+{
+    Node *head;
+    Node *tail;
+} MallocList;
+
+/// @brief appends a value at the tail
+/// @param list
+/// @param data
+static void mlist_append(MallocList *list, uint16_t data)
+{
+    Node *node = malloc(sizeof(Node));
+    my_assert(node != NULL);
+    node->data = data;
+    node->next = NULL;
+    if (list->tail != NULL)
+        list->tail->next = node;
+    else
+        list->head = node;
+    list->tail = node;
+}
+
+/// @brief inserts a value after a node
+/// @param list
+/// @param prevNode
+/// @param data
+static void mlist_add_after(MallocList *list, Node *prevNode, uint16_t data)
+{
+    Node *node = malloc(sizeof(Node));
+    my_assert(node != NULL);
+    node->data = data;
+    node->next = prevNode->next;
+    prevNode->next = node;
+    if (list->tail == prevNode)
+        list->tail = node;
+}
+
+/// @brief inserts a value before a node, finding its predecessor from the head
+/// @param list
+/// @param nextNode
+/// @param data
+static void mlist_add_before(MallocList *list, Node *nextNode, uint16_t data)
+{
+    Node *node = malloc(sizeof(Node));
+    my_assert(node != NULL);
+    node->data = data;
+    node->next = nextNode;
+    if (list->head == nextNode)
+    {
+        list->head = node;
+        return;
+    }
+    Node *current = list->head;
+    while (current->next != nextNode)
+        current = current->next;
+    current->next = node;
+}
+
+/// @brief finds the first node with a value
+/// @param list
+/// @param data
+/// @return
+static Node *mlist_find(MallocList *list, uint16_t data)
+{
+    Node *current = list->head;
+    while (current != NULL && current->data != data)
+        current = current->next;
+    return current;
+}
+
+/// @brief removes the first node with a value
+/// @param list
+/// @param data
+static void mlist_remove(MallocList *list, uint16_t data)
+{
+    Node *prev = NULL;
+    Node *current = list->head;
+    while (current != NULL && current->data != data)
+    {
+        prev = current;
+        current = current->next;
+    }
+    if (current == NULL)
+        return;
+    if (prev != NULL)
+        prev->next = current->next;
+    else
+        list->head = current->next;
+    if (list->tail == current)
+        list->tail = prev;
+    free(current);
+}
+
+/// @brief runs all operations on a MallocList
+/// @param input
+/// @param results
+static void bench_malloc(const BenchInput *input, BenchResult *results)
+{
+    BenchProbe probe;
+    size_t n = input->n;
+    MallocList list = {NULL, NULL};
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < n; i++)
+        mlist_append(&list, input->values[i]);
+    results[BENCH_INSERT] = bench_end(&probe, n);
+
+    uint64_t sum = 0;
+    bench_begin(&probe);
+    for (Node *current = list.head; current != NULL; current = current->next)
+        sum += current->data;
+    results[BENCH_TRAVERSE] = bench_end(&probe, n);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+        sum += (uintptr_t)mlist_find(&list, input->keys[i]);
+    results[BENCH_SEARCH] = bench_end(&probe, input->walkOps);
+
+    Node **nodes = malloc(n * sizeof(Node *));
+    my_assert(nodes != NULL);
+    size_t j = 0;
+    for (Node *current = list.head; current != NULL; current = current->next)
+        nodes[j++] = current;
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->fastOps; i++)
+        mlist_add_after(&list, nodes[input->positions[i]], input->values[i]);
+    results[BENCH_INSERT_AFTER] = bench_end(&probe, input->fastOps);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+        mlist_add_before(&list, nodes[input->positions[i]], input->values[i]);
+    results[BENCH_INSERT_BEFORE] = bench_end(&probe, input->walkOps);
+
+    bench_begin(&probe);
+    for (size_t i = 0; i < input->walkOps; i++)
+        mlist_remove(&list, input->keys[i]);
+    results[BENCH_DELETE] = bench_end(&probe, input->walkOps);
+    benchSink = sum;
+    free(nodes);
+
+    Node *current = list.head;
+    while (current != NULL)
+    {
+        Node *next = current->next;
+        free(current);
+        current = next;
+    }
+}
+
+/// @brief benchmarks all implementations at one list size and prints a table
+/// @param n
+static void bench_size(size_t n)
+{
+    BenchInput input = {.n = n};
+    input.fastOps = n < BENCH_FAST_OPS ? n : BENCH_FAST_OPS;
+    input.walkOps = BENCH_WALK_BUDGET / n;
+    if (input.walkOps < BENCH_WALK_OPS_MIN)
+        input.walkOps = BENCH_WALK_OPS_MIN;
+    if (input.walkOps > BENCH_WALK_OPS_MAX)
+        input.walkOps = BENCH_WALK_OPS_MAX;
+
+    uint16_t *values = malloc(n * sizeof(uint16_t));
+    size_t *positions = malloc(input.fastOps * sizeof(size_t));
+    uint16_t *keys = malloc(input.walkOps * sizeof(uint16_t));
+    my_assert(values != NULL && positions != NULL && keys != NULL);
+    for (size_t i = 0; i < n; i++)
+        values[i] = (uint16_t)rand();
+    for (size_t i = 0; i < input.fastOps; i++)
+        positions[i] = (size_t)rand() % n;
+    for (size_t i = 0; i < input.walkOps; i++)
+        keys[i] = values[(size_t)rand() % n];
+    input.values = values;
+    input.positions = positions;
+    input.keys = keys;
+
+    BenchResult results[BENCH_IMPLS][BENCH_OPS];
+    bench_array(&input, results[BENCH_ARRAY]);
+    bench_pool(&input, results[BENCH_POOL]);
+    bench_malloc(&input, results[BENCH_MALLOC]);
+
+    printf("\n%zu values (%zu fast ops, %zu walking ops):\n", n, input.fastOps, input.walkOps);
+    printf(" %-14s %38s   %32s\n", "", "ns per operation", "cache misses per operation");
+    printf(" %-14s %12s %12s %12s   %10s %10s %10s\n", "operation", "array", "pool", "malloc", "array", "pool", "malloc");
+    for (int op = 0; op < BENCH_OPS; op++)
+    {
+        printf(" %-14s", benchOpNames[op]);
+        for (int impl = 0; impl < BENCH_IMPLS; impl++)
+            printf(" %12.1f", results[impl][op].ns);
+        printf("  ");
+        for (int impl = 0; impl < BENCH_IMPLS; impl++)
+        {
+            if (results[impl][op].misses < 0)
+                printf(" %10s", "n/a");
+            else
+                printf(" %10.2f", results[impl][op].misses);
+        }
+        printf("\n");
+    }
+    free(values);
+    free(positions);
+    free(keys);
+}
+
+int main(int argc, char *argv[])
+{
+    srand(time(NULL));
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+
+    size_t maxSize = 10000000;
+    if (argc > 1)
+        maxSize = strtoull(argv[1], NULL, 10);
+    if (argc > 2 || maxSize == 0)
+    {
+        printf("Usage: %s [largest list size]\n", argv[0]);
+        printf("Times insert, traversal, search, insert_after, insert_before and delete on\n");
+        printf("a plain array, on List with pool nodes and on the same list with malloc nodes,\n");
+        printf("for 1K values and every tenfold size up to the largest, 10M by default.\n");
+        return 1;
+    }
+
+    missCounter = bench_open_counter();
+    if (missCounter < 0)
+        printf("Cache miss counter not available; misses are shown as n/a.\n");
+    for (size_t n = 1000; n <= maxSize; n *= 10)
+        bench_size(n);
+    if (missCounter >= 0)
+        close(missCounter);
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "compact_list.h"
+
+/// @brief allocates a node
+/// @param data
+/// @return the new node, or NULL if the pool is full
+static CNode *cnode_new(uint16_t data) {
+    CNode *node = (CNode *)mem_alloc(sizeof(CNode));
+    if (node == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc()\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    node->data = data;
+    node->pad = 0;
+    node->next = CLIST_NIL;
+    return node;
+}
+
+/// @brief links a node in after prev, or at the head if prev is NULL
+/// @param list
+/// @param prev
+/// @param node
+static void clist_link_after(CList *list, CNode *prev, CNode *node) {
+    uint32_t link = clist_link(node);
+    if (prev == NULL) {
+        node->next = list->head;
+        list->head = link;
+    } else {
+        node->next = prev->next;
+        prev->next = link;
+    }
+    if (node->next == CLIST_NIL) list->tail = link;
+    list->count++;
+}
+
+/**
+ * Initializes the list.
+ *
+ * @param list The list to initialize. It is left empty even on failure.
+ * @param size The size of the memory pool the nodes are taken from; at most
+ * 4 GiB.
+ * @return true on success, false if the pool is too large for 32-bit links,
+ * in which case no pool is set up.
+ */
+bool clist_init(CList *list, size_t size) {
+    *list = CLIST_EMPTY;
+    if (size >= CLIST_NIL) {
+        printf_red("Pool too large for 32-bit links\n");
+        return false;
+    }
+    mem_init(size);
+    return true;
+}
+
+/**
+ * Inserts a new node at the end of the list.
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ */
+void clist_insert(CList *list, uint16_t data) {
+    CNode *newNode = cnode_new(data);
+    if (newNode == NULL) return;
+    clist_link_after(list, clist_node(list->tail), newNode);
+}
+
+/**
+ * Inserts a new node after a given node.
+ *
+ * @param list The list.
+ * @param prevNode A pointer to the node after which the new node will be
+ * inserted.
+ * @param data The data to be inserted.
+ */
+void clist_insert_after(CList *list, CNode *prevNode, uint16_t data) {
+    if (prevNode == NULL) {
+        printf_red("Previous node cannot be NULL\n");
+        return;
+    }
+    CNode *newNode = cnode_new(data);
+    if (newNode == NULL) return;
+    clist_link_after(list, prevNode, newNode);
+}
+
+/**
+ * Inserts a new node before a given node.
+ *
+ * @param list The list.
+ * @param nextNode A pointer to the node before which the new node will be
+ * inserted.
+ * @param data The data to be inserted.
+ */
+void clist_insert_before(CList *list, CNode *nextNode, uint16_t data) {
+    if (nextNode == NULL) {
+        printf_red("Next node cannot be NULL\n");
+        return;
+    }
+
+    uint32_t target = clist_link(nextNode);
+    CNode *prev = NULL;
+    uint32_t current = list->head;
+    while (current != CLIST_NIL && current != target) {
+        prev = clist_node(current);
+        current = prev->next;
+    }
+    if (current == CLIST_NIL) return;
+
+    CNode *newNode = cnode_new(data);
+    if (newNode == NULL) return;
+    clist_link_after(list, prev, newNode);
+}
+
+/**
+ * Deletes the first node with the given data from the list.
+ *
+ * @param list The list.
+ * @param data The data of the node to be deleted.
+ */
+void clist_delete(CList *list, uint16_t data) {
+    CNode *prev = NULL;
+    CNode *current = clist_node(list->head);
+    while (current != NULL && current->data != data) {
+        prev = current;
+        current = clist_node(current->next);
+    }
+    if (current == NULL) return;
+
+    if (prev == NULL) {
+        list->head = current->next;
+    } else {
+        prev->next = current->next;
+    }
+    if (current->next == CLIST_NIL) list->tail = clist_link(prev);
+    list->count--;
+    mem_free(current);
+}
+
+/**
+ * Searches for a node with the given data in the list.
+ *
+ * @param list The list.
+ * @param data The data to search for.
+ * @return A pointer to the node with the given data, or NULL if not found.
+ */
+CNode *clist_search(CList *list, uint16_t data) {
+    for (CNode *current = clist_node(list->head); current != NULL; current = clist_node(current->next)) {
+        if (current->data == data) return current;
+    }
+    return NULL;
+}
+
+/**
+ * Displays the entire list.
+ *
+ * @param list The list.
+ */
+void clist_display(CList *list) {
+    if (list->head == CLIST_NIL) {
+        printf("NULL");
+        return;
+    }
+    clist_display_range(list, NULL, NULL);
+}
+
+/**
+ * Displays a selected range of the list.
+ *
+ * @param list The list.
+ * @param startNode A pointer to the starting node of the range.
+ * @param endNode A pointer to the ending node of the range.
+ */
+void clist_display_range(CList *list, CNode *startNode, CNode *endNode) {
+    if (list->head == CLIST_NIL) {
+        printf("[]");
+        return;
+    }
+
+    CNode *current = startNode ? startNode : clist_node(list->head);
+    CNode *stop = endNode ? clist_node(endNode->next) : NULL;
+    printf("[");
+    while (current != NULL && current != stop) {
+        printf("%d", current->data);
+        current = clist_node(current->next);
+        if (current != stop) {
+            printf(", ");
+        }
+    }
+    printf("]");
+}
+
+/**
+ * Counts the number of nodes in the list.
+ *
+ * @param list The list.
+ * @return The number of nodes in the list.
+ */
+int clist_count_nodes(CList *list) {
+    return (int)list->count;
+}
+
+/**
+ * Cleans up the list by freeing all nodes.
+ *
+ * @param list The list.
+ */
+void clist_cleanup(CList *list) {
+    CNode *current = clist_node(list->head);
+    while (current != NULL) {
+        CNode *next = clist_node(current->next);
+        mem_free(current);
+        current = next;
+    }
+    *list = CLIST_EMPTY;
+    mem_deinit();
+}
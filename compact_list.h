@@ -0,0 +1,56 @@
+#ifndef COMPACT_LIST_H
+#define COMPACT_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "memory_manager.h"
+
+// Link value that refers to no node.
+#define CLIST_NIL UINT32_MAX
+
+// A node that links to the next one by its offset into the pool instead of a
+// pointer, so that it packs into 8 bytes and a list can be moved or saved
+// along with its pool. Pools must be smaller than 4 GiB.
+typedef struct CNode {
+    uint16_t data;  // Stores the data as an unsigned 16-bit integer
+    uint16_t pad;   // Keeps next aligned
+    uint32_t next;  // Pool offset of the next node, or CLIST_NIL
+} CNode;
+
+// A list handle made of offsets only; it can be stored in the pool itself.
+typedef struct CList {
+    uint32_t head;   // offset of the first node, or CLIST_NIL
+    uint32_t tail;   // offset of the last node, or CLIST_NIL
+    uint32_t count;  // number of nodes
+} CList;
+
+#define CLIST_EMPTY ((CList){CLIST_NIL, CLIST_NIL, 0})
+
+bool clist_init(CList* list, size_t size);
+void clist_insert(CList* list, uint16_t data);
+void clist_insert_after(CList* list, CNode* prevNode, uint16_t data);
+void clist_insert_before(CList* list, CNode* nextNode, uint16_t data);
+void clist_delete(CList* list, uint16_t data);
+CNode* clist_search(CList* list, uint16_t data);
+void clist_display(CList* list);
+void clist_display_range(CList* list, CNode* startNode, CNode* endNode);
+int clist_count_nodes(CList* list);
+void clist_cleanup(CList* list);
+
+/// @brief returns the node a link refers to
+/// @param link
+/// @return the node, or NULL for CLIST_NIL
+static inline CNode* clist_node(uint32_t link) {
+    return link == CLIST_NIL ? NULL : (CNode*)mem_pointer(link);
+}
+
+/// @brief returns the link that refers to a node
+/// @param node
+/// @return the link, or CLIST_NIL for NULL
+static inline uint32_t clist_link(const CNode* node) {
+    return node == NULL ? CLIST_NIL : (uint32_t)mem_offset(node);
+}
+
+#endif
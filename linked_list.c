@@ -1,5 +1,306 @@
 #include "linked_list.h"
 
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Nodes between the one being visited and the one being prefetched.
+#define LIST_PREFETCH_DISTANCE 4
+// Values handed to a chunk visitor at once.
+#define LIST_VISIT_CHUNK 256
+
+/// @brief hands the values of the nodes from first up to, but not including,
+/// stop to fn in chunks, prefetching nodes ahead of the walk
+/// @param first
+/// @param stop NULL to walk to the end of the list
+/// @param fn
+/// @param ctx
+static void list_walk_chunks(Node *first, Node *stop, ListChunkVisitor fn, void *ctx) {
+    uint16_t values[LIST_VISIT_CHUNK];
+    size_t n = 0;
+    Node *ahead = first;
+    for (int i = 0; i < LIST_PREFETCH_DISTANCE && ahead != NULL; i++) {
+        ahead = ahead->next;
+        __builtin_prefetch(ahead);
+    }
+
+    for (Node *current = first; current != NULL && current != stop; current = current->next) {
+        // Each hop of the lookahead reads a node prefetched one hop earlier
+        if (ahead != NULL) {
+            ahead = ahead->next;
+            __builtin_prefetch(ahead);
+        }
+        values[n++] = current->data;
+        if (n == LIST_VISIT_CHUNK) {
+            fn(values, n, ctx);
+            n = 0;
+        }
+    }
+    if (n > 0) fn(values, n, ctx);
+}
+
+// State of list_gather_chunk across chunks.
+typedef struct ListGather {
+    uint16_t *values;
+    size_t n;
+} ListGather;
+
+/// @brief chunk visitor that appends the values to a ListGather
+/// @param values
+/// @param n
+/// @param ctx a ListGather
+static void list_gather_chunk(const uint16_t *values, size_t n, void *ctx) {
+    ListGather *gather = (ListGather *)ctx;
+    memcpy(gather->values + gather->n, values, n * sizeof(uint16_t));
+    gather->n += n;
+}
+
+/// @brief hands the values of a list to fn from the tail to the head, in
+/// chunks. Doubly linked lists are walked along their prev pointers; singly
+/// linked lists are walked forward once into a buffer that is then handed
+/// out back to front.
+/// @param list
+/// @param fn
+/// @param ctx
+/// @return false if the buffer for a singly linked list could not be allocated
+static bool list_walk_reverse_chunks(List *list, ListChunkVisitor fn, void *ctx) {
+    if (list->flags & LIST_DOUBLY) {
+        uint16_t values[LIST_VISIT_CHUNK];
+        size_t n = 0;
+        for (DNode *current = (DNode *)list->tail; current != NULL; current = current->prev) {
+            values[n++] = current->node.data;
+            if (n == LIST_VISIT_CHUNK) {
+                fn(values, n, ctx);
+                n = 0;
+            }
+        }
+        if (n > 0) fn(values, n, ctx);
+        return true;
+    }
+
+    if (list->count == 0) return true;
+    ListGather gather = {malloc(list->count * sizeof(uint16_t)), 0};
+    if (gather.values == NULL) return false;
+    list_walk_chunks(list->head, NULL, list_gather_chunk, &gather);
+
+    for (size_t i = 0, j = gather.n - 1; i < j; i++, j--) {
+        uint16_t value = gather.values[i];
+        gather.values[i] = gather.values[j];
+        gather.values[j] = value;
+    }
+    for (size_t i = 0; i < gather.n; i += LIST_VISIT_CHUNK) {
+        size_t n = gather.n - i < LIST_VISIT_CHUNK ? gather.n - i : LIST_VISIT_CHUNK;
+        fn(gather.values + i, n, ctx);
+    }
+    free(gather.values);
+    return true;
+}
+
+/// @brief chunk visitor that adds the chunk lengths up in a size_t
+/// @param values
+/// @param n
+/// @param ctx
+static void list_count_chunk(const uint16_t *values, size_t n, void *ctx) {
+    (void)values;
+    *(size_t *)ctx += n;
+}
+
+// Display output is assembled in chunks of this size and written with one
+// call per chunk.
+#define LIST_FORMAT_CHUNK 16384
+// Longest text for one element: ", 65535"
+#define LIST_FORMAT_ELEMENT_MAX 7
+
+// Collects formatted output in a buffer. With a flush function the buffer
+// is written out whenever it fills; without one, output that does not fit
+// is dropped but still counted.
+typedef struct ListFormatter {
+    char *buffer;
+    size_t size;   // usable bytes in buffer
+    size_t used;   // bytes in buffer not yet flushed
+    size_t total;  // bytes produced so far
+    bool (*flush)(struct ListFormatter *formatter);
+    void *ctx;     // passed to flush through the formatter
+    bool failed;   // a flush failed; further output is dropped
+} ListFormatter;
+
+/// @brief appends bytes, flushing or dropping what does not fit
+/// @param formatter
+/// @param text
+/// @param length
+static void list_format_put(ListFormatter *formatter, const char *text, size_t length) {
+    formatter->total += length;
+    while (length > 0 && !formatter->failed) {
+        if (formatter->used == formatter->size) {
+            if (formatter->flush == NULL || !formatter->flush(formatter)) return;
+            formatter->used = 0;
+        }
+        size_t room = formatter->size - formatter->used;
+        size_t part = length < room ? length : room;
+        memcpy(formatter->buffer + formatter->used, text, part);
+        formatter->used += part;
+        text += part;
+        length -= part;
+    }
+}
+
+/// @brief appends a value in decimal, preceded by a separator if requested
+/// @param formatter
+/// @param value
+/// @param separator
+static void list_format_value(ListFormatter *formatter, uint16_t value, bool separator) {
+    char digits[LIST_FORMAT_ELEMENT_MAX];
+    char *end = digits + sizeof(digits);
+    char *first = end;
+    do {
+        *--first = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    if (separator) {
+        *--first = ' ';
+        *--first = ',';
+    }
+
+    size_t length = end - first;
+    if (formatter->size - formatter->used >= length) {
+        // Fast path: the element fits in the buffer
+        memcpy(formatter->buffer + formatter->used, first, length);
+        formatter->used += length;
+        formatter->total += length;
+        return;
+    }
+    list_format_put(formatter, first, length);
+}
+
+// State of list_format_chunk across chunks.
+typedef struct ListFormatWalk {
+    ListFormatter *formatter;
+    bool separator;  // a value was formatted already
+} ListFormatWalk;
+
+/// @brief chunk visitor that formats values
+/// @param values
+/// @param n
+/// @param ctx a ListFormatWalk
+static void list_format_chunk(const uint16_t *values, size_t n, void *ctx) {
+    ListFormatWalk *walk = (ListFormatWalk *)ctx;
+    for (size_t i = 0; i < n; i++) {
+        list_format_value(walk->formatter, values[i], walk->separator);
+        walk->separator = true;
+    }
+}
+
+/// @brief formats the nodes from startNode through endNode with the rules of
+/// list_display_range
+/// @param formatter
+/// @param head
+/// @param startNode
+/// @param endNode
+static void list_format_nodes(ListFormatter *formatter, Node *head, Node *startNode, Node *endNode) {
+    if (head == NULL) {
+        list_format_put(formatter, "[]", 2);
+        return;
+    }
+
+    ListFormatWalk walk = {formatter, false};
+    list_format_put(formatter, "[", 1);
+    list_walk_chunks(startNode ? startNode : head, endNode ? endNode->next : NULL, list_format_chunk, &walk);
+    list_format_put(formatter, "]", 1);
+}
+
+/// @brief formats a non-empty list from the tail to the head with the rules of
+/// list_display; nothing is written if the walk could not run
+/// @param formatter
+/// @param list
+static void list_format_reverse(ListFormatter *formatter, List *list) {
+    ListFormatWalk walk = {formatter, false};
+    list_format_put(formatter, "[", 1);
+    if (!list_walk_reverse_chunks(list, list_format_chunk, &walk)) {
+        printf_red("Memory allocation failed in list_print_reverse()\n");
+        formatter->failed = true;
+        return;
+    }
+    list_format_put(formatter, "]", 1);
+}
+
+/// @brief flushes a formatter to the FILE in its ctx
+/// @param formatter
+/// @return false if the write failed
+static bool list_flush_file(ListFormatter *formatter) {
+    if (fwrite(formatter->buffer, 1, formatter->used, (FILE *)formatter->ctx) == formatter->used) return true;
+    formatter->failed = true;
+    return false;
+}
+
+/// @brief writes all of a buffer to a file descriptor, retrying short writes
+/// @param fd
+/// @param data
+/// @param length
+/// @return false if a write failed
+static bool list_write_all(int fd, const void *data, size_t length) {
+    const char *next = (const char *)data;
+    while (length > 0) {
+        ssize_t written = write(fd, next, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        next += written;
+        length -= written;
+    }
+    return true;
+}
+
+/// @brief flushes a formatter to the file descriptor in its ctx
+/// @param formatter
+/// @return false if the write failed
+static bool list_flush_fd(ListFormatter *formatter) {
+    if (list_write_all(*(int *)formatter->ctx, formatter->buffer, formatter->used)) return true;
+    formatter->failed = true;
+    return false;
+}
+
+/// @brief formats a list, or a range of it, into a caller's buffer
+/// @param head
+/// @param startNode
+/// @param endNode
+/// @param whole format as list_display rather than list_display_range
+/// @param buffer
+/// @param size
+/// @return the length of the complete text
+static size_t list_format_to_buffer(Node *head, Node *startNode, Node *endNode, bool whole, char *buffer, size_t size) {
+    ListFormatter formatter = {.buffer = buffer, .size = size ? size - 1 : 0};
+    if (whole && head == NULL) {
+        list_format_put(&formatter, "NULL", 4);
+    } else {
+        list_format_nodes(&formatter, head, startNode, endNode);
+    }
+    if (size) buffer[formatter.used] = '\0';
+    return formatter.total;
+}
+
+/// @brief formats a list, or a range of it, and writes it out in chunks
+/// @param head
+/// @param startNode
+/// @param endNode
+/// @param whole format as list_display rather than list_display_range
+/// @param reverse NULL, or the list of head to format from the tail to the head
+/// @param flush
+/// @param ctx
+/// @return false if writing failed
+static bool list_format_to_sink(Node *head, Node *startNode, Node *endNode, bool whole, List *reverse, bool (*flush)(ListFormatter *), void *ctx) {
+    char chunk[LIST_FORMAT_CHUNK];
+    ListFormatter formatter = {.buffer = chunk, .size = sizeof(chunk), .flush = flush, .ctx = ctx};
+    if (whole && head == NULL) {
+        list_format_put(&formatter, "NULL", 4);
+    } else if (reverse) {
+        list_format_reverse(&formatter, reverse);
+    } else {
+        list_format_nodes(&formatter, head, startNode, endNode);
+    }
+    if (formatter.used > 0 && !formatter.failed) flush(&formatter);
+    return !formatter.failed;
+}
+
 /**
  * Initializes the linked list.
  *
@@ -147,21 +448,7 @@ Node *list_search(Node **head, uint16_t data) {
  * @param head A pointer to the head of the list.
  */
 void list_display(Node **head) {
-    Node *current = *head;
-    if (current == NULL) {
-        printf("NULL");
-        return;
-    }
-
-    printf("[");
-    while (current != NULL) {
-        printf("%d", current->data);
-        current = current->next;
-        if (current) {
-            printf(", ");
-        }
-    }
-    printf("]");
+    list_format_to_sink(*head, NULL, NULL, true, NULL, list_flush_file, stdout);
 }
 
 /**
@@ -172,28 +459,62 @@ void list_display(Node **head) {
  * @param endNode A pointer to the ending node of the range.
  */
 void list_display_range(Node **head, Node *startNode, Node *endNode) {
-    Node *current = startNode;
-    if (*head == NULL) {
-        printf("[]");
-        return;
-    }
+    list_format_to_sink(*head, startNode, endNode, false, NULL, list_flush_file, stdout);
+}
 
-    if (!current) {
-        current = *head;
-    }
+/**
+ * Formats the entire list as list_display shows it, into a buffer. Like
+ * snprintf, the text is cut short if it does not fit and always terminated.
+ *
+ * @param head A pointer to the head of the list.
+ * @param buffer The buffer to fill.
+ * @param size The size of the buffer, including the terminating null.
+ * @return The length of the complete text, excluding the terminating null.
+ */
+size_t list_format(Node **head, char *buffer, size_t size) {
+    return list_format_to_buffer(*head, NULL, NULL, true, buffer, size);
+}
 
-    if (endNode) {
-        endNode = endNode->next;
-    }
-    printf("[");
-    while (current != NULL && current != endNode) {
-        printf("%d", current->data);
-        current = current->next;
-        if (current != endNode) {
-            printf(", ");
-        }
-    }
-    printf("]");
+/**
+ * Formats a selected range of the list as list_display_range shows it, into
+ * a buffer. Like snprintf, the text is cut short if it does not fit and
+ * always terminated.
+ *
+ * @param head A pointer to the head of the list.
+ * @param startNode A pointer to the starting node of the range.
+ * @param endNode A pointer to the ending node of the range.
+ * @param buffer The buffer to fill.
+ * @param size The size of the buffer, including the terminating null.
+ * @return The length of the complete text, excluding the terminating null.
+ */
+size_t list_format_range(Node **head, Node *startNode, Node *endNode, char *buffer, size_t size) {
+    return list_format_to_buffer(*head, startNode, endNode, false, buffer, size);
+}
+
+/**
+ * Writes the entire list as list_display shows it to a file descriptor, in
+ * large writes that bypass stdio.
+ *
+ * @param head A pointer to the head of the list.
+ * @param fd The file descriptor.
+ * @return true on success, false if a write failed.
+ */
+bool list_write(Node **head, int fd) {
+    return list_format_to_sink(*head, NULL, NULL, true, NULL, list_flush_fd, &fd);
+}
+
+/**
+ * Writes a selected range of the list as list_display_range shows it to a
+ * file descriptor, in large writes that bypass stdio.
+ *
+ * @param head A pointer to the head of the list.
+ * @param startNode A pointer to the starting node of the range.
+ * @param endNode A pointer to the ending node of the range.
+ * @param fd The file descriptor.
+ * @return true on success, false if a write failed.
+ */
+bool list_write_range(Node **head, Node *startNode, Node *endNode, int fd) {
+    return list_format_to_sink(*head, startNode, endNode, false, NULL, list_flush_fd, &fd);
 }
 
 /**
@@ -203,13 +524,9 @@ void list_display_range(Node **head, Node *startNode, Node *endNode) {
  * @return The number of nodes in the list.
  */
 int list_count_nodes(Node **head) {
-    int count = 0;
-    Node *current = *head;
-    while (current != NULL) {
-        count++;
-        current = current->next;
-    }
-    return count;
+    size_t count = 0;
+    list_walk_chunks(*head, NULL, list_count_chunk, &count);
+    return (int)count;
 }
 
 /**
@@ -228,3 +545,1809 @@ void list_cleanup(Node **head) {
     *head = NULL;
     mem_deinit();
 }
+
+// ********* List handle *********
+// The functions below keep a List's tail and count up to date. The Node**
+// functions above remain for code that only tracks a head pointer.
+
+// Optional index from a value to the nodes holding it and their
+// predecessors. Open addressing with linear probing, kept in the list's pool.
+// While the index is enabled every node carries an order label that grows
+// along the list, so that the nodes of a value stay sorted by position and a
+// node is found among them by binary search.
+typedef struct ListOccurrence {
+    Node *node;
+    Node *prev;  // predecessor of node, NULL if node is the head
+} ListOccurrence;
+
+// The nodes of a value in list order, in items[start, end). Items are
+// shifted from whichever side is shorter. Arrays are carved out of a slab of
+// the index, in units the size of an item, so that growing them does not
+// fragment the pool; the header takes one unit.
+typedef struct ListOccurrences {
+    uint32_t start;
+    uint32_t end;
+    uint32_t capacity;
+    uint32_t value;  // the value whose nodes these are
+    ListOccurrence items[];
+} ListOccurrences;
+
+typedef struct ListIndexEntry {
+    Node *node;  // first node with the value, NULL for an empty slot
+    union {
+        Node *prev;              // predecessor of node, NULL if node is the head
+        ListOccurrences *more;   // all nodes with the value, once it had several
+    };
+    uint32_t count;  // number of nodes with the value
+    uint16_t value;
+    bool many;       // whether more is used instead of prev
+} ListIndexEntry;
+
+// The header is 32 bytes, so that a freed table leaves a hole that nodes
+// fill exactly.
+typedef struct ListIndex {
+    size_t capacity;    // number of slots, a power of two
+    uint32_t used;      // number of distinct values
+    uint32_t bits;      // log2 of capacity
+    char *slab;         // occurrence arrays, NULL until a value has several nodes
+    uint32_t slabSize;  // size of the slab in units
+    uint32_t slabUsed;  // units handed out; arrays that grew leave theirs unused
+    ListIndexEntry entries[];
+} ListIndex;
+
+#define LIST_INDEX_MIN_BITS 4
+// Enough for twice the number of distinct values
+#define LIST_INDEX_MAX_BITS 17
+#define LIST_OCCURRENCES_MIN 2
+// Gap left between labels of nodes appended or prepended, so that runs of
+// them do not use up the label range
+#define LIST_ORDER_STEP 4096u
+
+/// @brief allocates memory for a list from its pool
+/// @param list
+/// @param size
+/// @return
+static void *list_pool_alloc(List *list, size_t size) {
+    return mem_pool_alloc(list->pool, size);
+}
+
+/// @brief allocates count adjacent blocks for a list from its pool
+/// @param list
+/// @param size
+/// @param count
+/// @return the first block
+static void *list_pool_alloc_batch(List *list, size_t size, size_t count) {
+    return mem_pool_alloc_batch(list->pool, size, count);
+}
+
+/// @brief returns memory of a list to its pool
+/// @param list
+/// @param block
+static void list_pool_free(List *list, void *block) {
+    mem_pool_free(list->pool, block);
+}
+
+/// @brief returns several blocks of a list to its pool at once
+/// @param list
+/// @param blocks
+/// @param count
+static void list_pool_free_batch(List *list, void **blocks, size_t count) {
+    mem_pool_free_batch(list->pool, blocks, count);
+}
+
+/// @brief returns the home slot of a value
+/// @param index
+/// @param value
+/// @return
+static size_t list_index_slot(const ListIndex *index, uint16_t value) {
+    return ((uint32_t)value * 2654435761u) >> (32 - index->bits);
+}
+
+/// @brief looks up the entry of a value
+/// @param index
+/// @param value
+/// @return the entry, or NULL if no node holds the value
+static ListIndexEntry *list_index_find(ListIndex *index, uint16_t value) {
+    size_t mask = index->capacity - 1;
+    for (size_t slot = list_index_slot(index, value);; slot = (slot + 1) & mask) {
+        ListIndexEntry *entry = &index->entries[slot];
+        if (entry->node == NULL) return NULL;
+        if (entry->value == value) return entry;
+    }
+}
+
+/// @brief allocates an empty index table
+/// @param list
+/// @param bits
+/// @return
+static ListIndex *list_index_new(List *list, unsigned bits) {
+    size_t capacity = (size_t)1 << bits;
+    ListIndex *index = list_pool_alloc(list, sizeof(ListIndex) + capacity * sizeof(ListIndexEntry));
+    if (index == NULL) return NULL;
+    index->capacity = capacity;
+    index->used = 0;
+    index->bits = bits;
+    index->slab = NULL;
+    index->slabSize = 0;
+    index->slabUsed = 0;
+    memset(index->entries, 0, capacity * sizeof(ListIndexEntry));
+    return index;
+}
+
+/// @brief claims the slot for a value that is not in the table yet
+/// @param index
+/// @param value
+/// @return
+static ListIndexEntry *list_index_claim(ListIndex *index, uint16_t value) {
+    size_t mask = index->capacity - 1;
+    size_t slot = list_index_slot(index, value);
+    while (index->entries[slot].node != NULL) slot = (slot + 1) & mask;
+    index->entries[slot].value = value;
+    index->used++;
+    return &index->entries[slot];
+}
+
+/// @brief returns the occurrence arrays of an index to the pool
+/// @param list
+static void list_index_free_occurrences(List *list) {
+    ListIndex *index = list->index;
+    if (index->slab == NULL) return;
+    for (size_t slot = 0; slot < index->capacity; slot++) {
+        ListIndexEntry *entry = &index->entries[slot];
+        if (entry->node != NULL && entry->many) {
+            entry->many = false;
+            entry->prev = NULL;
+        }
+    }
+    list_pool_free(list, index->slab);
+    index->slab = NULL;
+    index->slabSize = 0;
+    index->slabUsed = 0;
+}
+
+/// @brief returns the capacity an occurrence array of n items gets when it
+/// is built or moved, which leaves it half empty
+/// @param n
+/// @return
+static uint32_t list_index_fit(uint32_t n) {
+    return (2 * n > LIST_OCCURRENCES_MIN) ? 2 * n : LIST_OCCURRENCES_MIN;
+}
+
+/// @brief returns the occurrence array at a unit of the slab of an index
+/// @param index
+/// @param unit
+/// @return
+static ListOccurrences *list_index_slab_at(const ListIndex *index, size_t unit) {
+    return (ListOccurrences *)(index->slab + unit * sizeof(ListOccurrence));
+}
+
+/// @brief slides the arrays in use to the start of the slab, shrunk to fit,
+/// over those left behind by arrays that grew and values that went away
+/// @param index
+/// @return the number of units in use
+static size_t list_index_slab_compact(ListIndex *index) {
+    size_t used = 0;
+    for (size_t unit = 0; unit < index->slabUsed;) {
+        ListOccurrences *more = list_index_slab_at(index, unit);
+        unit += 1 + (size_t)more->capacity;
+        ListIndexEntry *entry = list_index_find(index, (uint16_t)more->value);
+        if (entry == NULL || !entry->many || entry->more != more) continue;
+
+        // The array moves down and does not grow, so it never overwrites
+        // the arrays after it
+        uint32_t value = more->value;
+        uint32_t n = more->end - more->start;
+        uint32_t capacity = list_index_fit(n);
+        if (capacity > more->capacity) capacity = more->capacity;
+        uint32_t start = (capacity - n) / 2;
+        ListOccurrences *moved = list_index_slab_at(index, used);
+        memmove(moved->items + start, more->items + more->start, n * sizeof(ListOccurrence));
+        moved->start = start;
+        moved->end = start + n;
+        moved->capacity = capacity;
+        moved->value = value;
+        entry->more = moved;
+        used += 1 + (size_t)capacity;
+    }
+    index->slabUsed = (uint32_t)used;
+    return used;
+}
+
+/// @brief moves the arrays of an index to a new slab of a given size. If
+/// the pool has no room for it next to the old slab, the old one is set
+/// aside in the heap and freed first, so that the new one can take its place.
+/// @param list
+/// @param size in units, at least slabUsed
+/// @return false if the pool has no room for the slab, in which case the
+/// arrays stay where they were, or are lost if even that room was taken
+static bool list_index_slab_move(List *list, size_t size) {
+    ListIndex *index = list->index;
+    if (size > UINT32_MAX) return false;
+    size_t used = (size_t)index->slabUsed * sizeof(ListOccurrence);
+    bool moved = true;
+    char *slab = list_pool_alloc(list, size * sizeof(ListOccurrence));
+    if (slab != NULL) {
+        if (index->slab) memcpy(slab, index->slab, used);
+        if (index->slab) list_pool_free(list, index->slab);
+    } else {
+        if (index->slab == NULL) return false;
+        char *copy = malloc(used + 1);
+        if (copy == NULL) return false;
+        memcpy(copy, index->slab, used);
+        list_pool_free(list, index->slab);
+        slab = list_pool_alloc(list, size * sizeof(ListOccurrence));
+        if (slab == NULL) {
+            moved = false;
+            size = index->slabSize;
+            slab = list_pool_alloc(list, size * sizeof(ListOccurrence));
+        }
+        if (slab != NULL) memcpy(slab, copy, used);
+        free(copy);
+        if (slab == NULL) {
+            index->slab = NULL;
+            index->slabSize = 0;
+            index->slabUsed = 0;
+            return false;
+        }
+    }
+
+    index->slab = slab;
+    index->slabSize = (uint32_t)size;
+    for (size_t unit = 0; unit < index->slabUsed;) {
+        ListOccurrences *more = list_index_slab_at(index, unit);
+        list_index_find(index, (uint16_t)more->value)->more = more;
+        unit += 1 + (size_t)more->capacity;
+    }
+    return moved;
+}
+
+/// @brief takes an occurrence array from the slab of an index. When the slab
+/// is full it is compacted, and replaced by a larger one only if that leaves
+/// less than a quarter of the units in use free, which keeps compacting
+/// amortized cheap.
+/// @param list
+/// @param capacity
+/// @param value
+/// @return the array, or NULL if the pool has no room for a new slab
+static ListOccurrences *list_index_slab_alloc(List *list, uint32_t capacity, uint16_t value) {
+    ListIndex *index = list->index;
+    size_t units = 1 + (size_t)capacity;
+    if (index->slabSize - index->slabUsed < units) {
+        size_t size = list_index_slab_compact(index) + units;
+        size += size / 4;
+        if (index->slabSize < size && !list_index_slab_move(list, size)) return NULL;
+    }
+
+    ListOccurrences *more = list_index_slab_at(index, index->slabUsed);
+    index->slabUsed += units;
+    more->capacity = capacity;
+    more->value = value;
+    return more;
+}
+
+/// @brief removes an entry, shifting later entries of its probe run back
+/// @param index
+/// @param entry
+static void list_index_erase(ListIndex *index, ListIndexEntry *entry) {
+    size_t mask = index->capacity - 1;
+    size_t hole = entry - index->entries;
+    for (size_t slot = (hole + 1) & mask; index->entries[slot].node != NULL; slot = (slot + 1) & mask) {
+        size_t home = list_index_slot(index, index->entries[slot].value);
+        // Move the entry if its home is not between the hole and its slot
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            index->entries[hole] = index->entries[slot];
+            hole = slot;
+        }
+    }
+    memset(&index->entries[hole], 0, sizeof(ListIndexEntry));
+    index->used--;
+}
+
+/// @brief finds where a node is, or belongs, among the nodes of its value
+/// @param more
+/// @param node
+/// @return the position of the first item not before node
+static uint32_t list_index_search(const ListOccurrences *more, const Node *node) {
+    uint32_t lo = more->start;
+    uint32_t hi = more->end;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (more->items[mid].node->order < node->order) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/// @brief inserts a node at a position of the occurrence array of a value,
+/// taking a new array if *moreRef is NULL. When the side to shift into is
+/// full the items are recentred, in an array twice as large if they fill
+/// more than half of it, so that the shifting is amortized constant at either end.
+/// @param list
+/// @param moreRef
+/// @param pos
+/// @param node
+/// @param prev
+/// @return false if the pool has no room for a new slab
+static bool list_index_insert(List *list, ListOccurrences **moreRef, uint32_t pos, Node *node, Node *prev) {
+    ListOccurrences *more = *moreRef;
+    ListOccurrence item = {node, prev};
+    bool front = more != NULL && pos - more->start < more->end - pos;
+    if (more != NULL && (front ? more->start > 0 : more->end < more->capacity)) {
+        if (front) {
+            memmove(&more->items[more->start - 1], &more->items[more->start], (pos - more->start) * sizeof(ListOccurrence));
+            more->start--;
+            more->items[pos - 1] = item;
+        } else {
+            memmove(&more->items[pos + 1], &more->items[pos], (more->end - pos) * sizeof(ListOccurrence));
+            more->end++;
+            more->items[pos] = item;
+        }
+        return true;
+    }
+
+    uint32_t n = more ? more->end - more->start : 0;
+    uint32_t before = more ? pos - more->start : 0;
+    uint32_t capacity = more ? more->capacity : LIST_OCCURRENCES_MIN;
+    if (2 * n > capacity) capacity *= 2;
+    ListOccurrences *target = more;
+    if (more == NULL || capacity != more->capacity) {
+        target = list_index_slab_alloc(list, capacity, node->data);
+        if (target == NULL) return false;
+        more = *moreRef;  // a new slab moves the array
+    }
+
+    // Copy the items before and after pos around a hole for the new one. In
+    // place, the part moving towards the other is copied first.
+    uint32_t start = (capacity - n - 1) / 2;
+    if (more != NULL) {
+        ListOccurrence *items = &more->items[more->start];
+        size_t headSize = before * sizeof(ListOccurrence);
+        size_t tailSize = (n - before) * sizeof(ListOccurrence);
+        if (start <= more->start) {
+            memmove(&target->items[start], items, headSize);
+            memmove(&target->items[start + before + 1], items + before, tailSize);
+        } else {
+            memmove(&target->items[start + before + 1], items + before, tailSize);
+            memmove(&target->items[start], items, headSize);
+        }
+    }
+    target->start = start;
+    target->end = start + n + 1;
+    target->items[start + before] = item;
+    *moreRef = target;
+    return true;
+}
+
+/// @brief removes the item at a position of an occurrence array
+/// @param more
+/// @param pos
+static void list_index_remove_at(ListOccurrences *more, uint32_t pos) {
+    if (pos - more->start < more->end - 1 - pos) {
+        memmove(&more->items[more->start + 1], &more->items[more->start], (pos - more->start) * sizeof(ListOccurrence));
+        more->start++;
+    } else {
+        memmove(&more->items[pos], &more->items[pos + 1], (more->end - 1 - pos) * sizeof(ListOccurrence));
+        more->end--;
+    }
+}
+
+/// @brief returns the predecessor of the first node of a value
+/// @param entry
+/// @return
+static Node *list_index_first_prev(const ListIndexEntry *entry) {
+    return entry->many ? entry->more->items[entry->more->start].prev : entry->prev;
+}
+
+/// @brief finds where the index keeps the predecessor of a node
+/// @param index
+/// @param node
+/// @return the predecessor field, or NULL if the index has no record of node
+static Node **list_index_prev_of(ListIndex *index, Node *node) {
+    ListIndexEntry *entry = list_index_find(index, node->data);
+    if (entry == NULL) return NULL;
+    if (!entry->many) return entry->node == node ? &entry->prev : NULL;
+    uint32_t pos = list_index_search(entry->more, node);
+    if (pos == entry->more->end || entry->more->items[pos].node != node) return NULL;
+    return &entry->more->items[pos].prev;
+}
+
+/// @brief spreads the order labels of all nodes evenly over the middle half
+/// of their range, leaving room to append and prepend
+/// @param list
+static void list_index_relabel(List *list) {
+    uint64_t step = ((uint64_t)1 << 31) / (list->count + 1);
+    uint64_t order = (uint64_t)1 << 30;
+    for (Node *current = list->head; current != NULL; current = current->next) {
+        order += step;
+        current->order = (uint32_t)order;
+    }
+}
+
+/// @brief gives a node that was just linked in after prev a label between
+/// those of its neighbours. If they are adjacent, the labels from the node
+/// on are spread over a range that grows until it holds more than the
+/// square of its node count, which keeps relabeling amortized cheap.
+/// @param list
+/// @param prev
+/// @param node
+static void list_index_label(List *list, Node *prev, Node *node) {
+    Node *next = node->next;
+    uint64_t lo = prev ? prev->order : 0;
+    uint64_t hi = next ? next->order : (uint64_t)1 << 32;
+    uint64_t gap = (hi - lo) / 2;
+    if (gap > 0) {
+        if (prev == NULL && next != NULL) {
+            node->order = (uint32_t)(hi - (gap < LIST_ORDER_STEP ? gap : LIST_ORDER_STEP));
+        } else if (next == NULL && prev != NULL) {
+            node->order = (uint32_t)(lo + (gap < LIST_ORDER_STEP ? gap : LIST_ORDER_STEP));
+        } else {
+            node->order = (uint32_t)(lo + gap);
+        }
+        return;
+    }
+
+    uint64_t n = 1;
+    while (next != NULL && next->order - lo <= n * n) {
+        next = next->next;
+        n++;
+    }
+    hi = next ? next->order : (uint64_t)1 << 32;
+    if (hi - lo <= n * n) {
+        list_index_relabel(list);
+        return;
+    }
+    uint64_t step = (hi - lo) / (n + 1);
+    for (Node *current = node; current != next; current = current->next) {
+        lo += step;
+        current->order = (uint32_t)lo;
+    }
+}
+
+/// @brief rebuilds the index of a list from scratch, sizing the table for
+/// the distinct values and the slab for the values with several nodes
+/// @param list
+/// @return false if the pool has no room for the index, in which case it is
+/// disabled
+static bool list_index_rebuild(List *list) {
+    uint64_t seen[(UINT16_MAX + 1) / 64] = {0};
+    size_t distinct = 0;
+    for (Node *current = list->head; current != NULL; current = current->next) {
+        uint64_t bit = (uint64_t)1 << (current->data % 64);
+        if (!(seen[current->data / 64] & bit)) {
+            seen[current->data / 64] |= bit;
+            distinct++;
+        }
+    }
+    // The same rule as list_index_linked grows the table by
+    unsigned bits = LIST_INDEX_MIN_BITS;
+    while (bits < LIST_INDEX_MAX_BITS && ((size_t)1 << bits) < 2 * (distinct + 1)) bits++;
+
+    if (list->index) list_index_free_occurrences(list);
+    if (list->index == NULL || list->index->bits != bits) {
+        ListIndex *index = list_index_new(list, bits);
+        if (index == NULL) {
+            list_index_disable(list);
+            return false;
+        }
+        if (list->index) list_pool_free(list, list->index);
+        list->index = index;
+    } else {
+        memset(list->index->entries, 0, list->index->capacity * sizeof(ListIndexEntry));
+        list->index->used = 0;
+    }
+
+    ListIndex *index = list->index;
+    list_index_relabel(list);
+    Node *prev = NULL;
+    for (Node *current = list->head; current != NULL; prev = current, current = current->next) {
+        ListIndexEntry *entry = list_index_find(index, current->data);
+        if (entry == NULL) {
+            entry = list_index_claim(index, current->data);
+            entry->node = current;
+            entry->prev = prev;
+        }
+        entry->count++;
+    }
+
+    // Give each value with several nodes an array, then fill them in list order
+    size_t units = 0;
+    for (size_t slot = 0; slot < index->capacity; slot++) {
+        if (index->entries[slot].count > 1) units += 1 + (size_t)list_index_fit(index->entries[slot].count);
+    }
+    if (units == 0) return true;
+    if (!list_index_slab_move(list, units)) {
+        list_index_disable(list);
+        return false;
+    }
+    for (size_t slot = 0; slot < index->capacity; slot++) {
+        ListIndexEntry *entry = &index->entries[slot];
+        if (entry->count < 2) continue;
+        ListOccurrences *more = list_index_slab_at(index, index->slabUsed);
+        more->capacity = list_index_fit(entry->count);
+        more->value = entry->value;
+        more->start = (more->capacity - entry->count) / 2;
+        more->end = more->start;
+        entry->more = more;
+        entry->many = true;
+        index->slabUsed += 1 + more->capacity;
+    }
+    prev = NULL;
+    for (Node *current = list->head; current != NULL; prev = current, current = current->next) {
+        ListIndexEntry *entry = list_index_find(index, current->data);
+        if (entry->many) entry->more->items[entry->more->end++] = (ListOccurrence){current, prev};
+    }
+    return true;
+}
+
+/// @brief records a node that was just linked in after prev
+/// @param list
+/// @param prev
+/// @param node
+static void list_index_linked(List *list, Node *prev, Node *node) {
+    ListIndex *index = list->index;
+    ListIndexEntry *entry = list_index_find(index, node->data);
+    if (entry == NULL && index->bits < LIST_INDEX_MAX_BITS && 2 * (index->used + 1) > index->capacity) {
+        // list_index_rebuild sees the node already, so there is nothing left to do
+        if (!list_index_rebuild(list)) {
+            printf_red("%s,%d No room to grow the list index, disabling it\n", __FILE__, __LINE__);
+        }
+        return;
+    }
+
+    list_index_label(list, prev, node);
+    // The node is now the predecessor of its successor
+    if (node->next) *list_index_prev_of(index, node->next) = node;
+
+    if (entry == NULL) {
+        entry = list_index_claim(index, node->data);
+        entry->node = node;
+        entry->prev = prev;
+        entry->count = 1;
+        return;
+    }
+
+    // The value is already present; the node goes among its nodes by label
+    if (!entry->many) {
+        ListOccurrences *more = NULL;
+        if (!list_index_insert(list, &more, 0, entry->node, entry->prev)) {
+            printf_red("%s,%d No room to grow the list index, disabling it\n", __FILE__, __LINE__);
+            list_index_disable(list);
+            return;
+        }
+        entry->more = more;
+        entry->many = true;
+    }
+    if (!list_index_insert(list, &entry->more, list_index_search(entry->more, node), node, prev)) {
+        printf_red("%s,%d No room to grow the list index, disabling it\n", __FILE__, __LINE__);
+        list_index_disable(list);
+        return;
+    }
+    entry->node = entry->more->items[entry->more->start].node;
+    entry->count++;
+}
+
+/// @brief updates the index for a node that is about to be unlinked
+/// @param list
+/// @param prev
+/// @param node
+static void list_index_unlinking(List *list, Node *prev, Node *node) {
+    ListIndex *index = list->index;
+    ListIndexEntry *entry = list_index_find(index, node->data);
+    entry->count--;
+    if (entry->count == 0) {
+        list_index_erase(index, entry);
+    } else {
+        list_index_remove_at(entry->more, list_index_search(entry->more, node));
+        entry->node = entry->more->items[entry->more->start].node;
+    }
+
+    // The node's predecessor becomes that of its successor
+    if (node->next) *list_index_prev_of(index, node->next) = prev;
+}
+
+/// @brief allocates a node for a list
+/// @param list
+/// @param data
+/// @return the new node, or NULL if the pool is full
+static Node *list_node_new(List *list, uint16_t data) {
+    size_t size = (list->flags & LIST_DOUBLY) ? sizeof(DNode) : sizeof(Node);
+    Node *node = (Node *)list_pool_alloc(list, size);
+    if (node == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc()\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    node->data = data;
+    node->next = NULL;
+    return node;
+}
+
+/// @brief returns a node of a list to the pool
+/// @param list
+/// @param node
+static void list_node_free(List *list, Node *node) {
+    list_pool_free(list, node);
+}
+
+/// @brief links a node into a list after prev, or at the head if prev is NULL
+/// @param list
+/// @param prev
+/// @param node
+static void list_link_after(List *list, Node *prev, Node *node) {
+    if (prev == NULL) {
+        node->next = list->head;
+        list->head = node;
+    } else {
+        node->next = prev->next;
+        prev->next = node;
+    }
+    if (list->flags & LIST_DOUBLY) {
+        ((DNode *)node)->prev = (DNode *)prev;
+        if (node->next) ((DNode *)node->next)->prev = (DNode *)node;
+    }
+    if (node->next == NULL) list->tail = node;
+    list->count++;
+    if (list->index) list_index_linked(list, prev, node);
+}
+
+/// @brief unlinks the node following prev, or the head if prev is NULL
+/// @param list
+/// @param prev
+/// @param node
+static void list_unlink_after(List *list, Node *prev, Node *node) {
+    if (list->index) list_index_unlinking(list, prev, node);
+    if (prev == NULL) {
+        list->head = node->next;
+    } else {
+        prev->next = node->next;
+    }
+    if ((list->flags & LIST_DOUBLY) && node->next) ((DNode *)node->next)->prev = (DNode *)prev;
+    if (list->tail == node) list->tail = prev;
+    list->count--;
+}
+
+/// @brief finds the node before a given node, in constant time for doubly
+/// linked lists, which trust that node is in the list, and through the value
+/// index if it is enabled
+/// @param list
+/// @param node
+/// @param prev set to the predecessor, or NULL if node is the head
+/// @return true if node is in the list
+static bool list_find_prev(List *list, Node *node, Node **prev) {
+    if ((list->flags & LIST_DOUBLY) && node) {
+        *prev = (Node *)((DNode *)node)->prev;
+        return true;
+    }
+
+    Node **indexed = (list->index && node) ? list_index_prev_of(list->index, node) : NULL;
+    if (indexed != NULL) {
+        *prev = *indexed;
+        return true;
+    }
+
+    Node *current = NULL;
+    Node *next = list->head;
+    while (next != NULL && next != node) {
+        current = next;
+        next = next->next;
+    }
+    *prev = current;
+    return next != NULL;
+}
+
+/**
+ * Initializes a list handle and the memory pool its nodes are taken from.
+ * The default pool is set up for the list if it is not yet initialized;
+ * otherwise the list gets a pool of its own, as with list_create_pool, so
+ * the nodes of lists already in the default pool stay intact.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool.
+ */
+void list_create(List *list, size_t size) {
+    list_create_ex(list, size, 0);
+}
+
+/**
+ * Initializes a list handle with flags and the memory pool its nodes are
+ * taken from, like list_create. With LIST_DOUBLY the nodes are DNodes, which
+ * cost a pointer more each but make list_add_before, list_remove_node and
+ * list_prev take constant time.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool.
+ * @param flags A combination of LIST_* flags, or 0.
+ */
+void list_create_ex(List *list, size_t size, unsigned flags) {
+    if (mem_initialized()) {
+        // Never re-initialize a pool other lists' nodes live in. Should no
+        // pool of its own be available, the list shares the default one.
+        if (!list_create_pool(list, size, flags)) list_create_in(list, NULL, flags);
+        return;
+    }
+    mem_init(size);
+    list_create_in(list, NULL, flags);
+    list->ownsPool = true;
+}
+
+/**
+ * Initializes a list handle whose nodes are taken from a pool of its own,
+ * so that any number of such lists can live next to each other and next to
+ * one made with list_create. list_destroy releases the pool with all nodes
+ * in it at once.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the list's memory pool.
+ * @param flags A combination of LIST_* flags, or 0.
+ * @return true on success, false if the pool cannot be allocated.
+ */
+bool list_create_pool(List *list, size_t size, unsigned flags) {
+    MemPool *pool = mem_pool_create(size);
+    if (pool == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_pool_create()\n", __FILE__, __LINE__);
+        return false;
+    }
+    list_create_in(list, pool, flags);
+    list->ownsPool = true;
+    return true;
+}
+
+/**
+ * Initializes a list handle whose nodes are taken from a pool chosen by the
+ * caller, which several lists may share. list_destroy frees the list's
+ * nodes but leaves the pool to the caller.
+ *
+ * @param list The list to initialize.
+ * @param pool A pool made with mem_pool_create, or NULL for the default
+ * pool, which must have been set up with mem_init.
+ * @param flags A combination of LIST_* flags, or 0.
+ */
+void list_create_in(List *list, MemPool *pool, unsigned flags) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    list->index = NULL;
+    list->flags = flags;
+    list->pool = pool;
+    list->ownsPool = false;
+}
+
+/**
+ * Inserts a new node at the end of the list in constant time.
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ */
+void list_append(List *list, uint16_t data) {
+    Node *newNode = list_node_new(list, data);
+    if (newNode == NULL) return;
+    list_link_after(list, list->tail, newNode);
+}
+
+/**
+ * Appends the values of an array to the list. All nodes are taken from the
+ * pool in one block search and lie next to each other in list order, so
+ * walking them later is sequential. Each node can still be removed on its
+ * own.
+ *
+ * @param list The list.
+ * @param values The values to append.
+ * @param n The number of values.
+ * @return true on success, false if the pool has no free run for all n nodes,
+ * in which case the list is unchanged.
+ */
+bool list_append_array(List *list, const uint16_t *values, size_t n) {
+    if (n == 0) return true;
+    size_t size = (list->flags & LIST_DOUBLY) ? sizeof(DNode) : sizeof(Node);
+    char *nodes = (char *)list_pool_alloc_batch(list, size, n);
+    if (nodes == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc_batch()\n", __FILE__, __LINE__);
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        Node *node = (Node *)(nodes + i * size);
+        node->data = values[i];
+        list_link_after(list, list->tail, node);
+    }
+    return true;
+}
+
+/**
+ * Initializes a list handle and its memory pool, and fills the list with the
+ * values of an array as list_append_array does.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool.
+ * @param values The values of the list.
+ * @param n The number of values.
+ * @return true on success, false if the pool has no room for n nodes, in
+ * which case the list is empty.
+ */
+bool list_from_array(List *list, size_t size, const uint16_t *values, size_t n) {
+    list_create(list, size);
+    return list_append_array(list, values, n);
+}
+
+/**
+ * Inserts a new node at the start of the list.
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ */
+void list_prepend(List *list, uint16_t data) {
+    Node *newNode = list_node_new(list, data);
+    if (newNode == NULL) return;
+    list_link_after(list, NULL, newNode);
+}
+
+/**
+ * Inserts a new node after a given node.
+ *
+ * @param list The list.
+ * @param prevNode A pointer to the node after which the new node will be
+ * inserted.
+ * @param data The data to be inserted.
+ */
+void list_add_after(List *list, Node *prevNode, uint16_t data) {
+    if (prevNode == NULL) {
+        printf_red("Previous node cannot be NULL\n");
+        return;
+    }
+    Node *newNode = list_node_new(list, data);
+    if (newNode == NULL) return;
+    list_link_after(list, prevNode, newNode);
+}
+
+/**
+ * Inserts a new node before a given node.
+ *
+ * @param list The list.
+ * @param nextNode A pointer to the node before which the new node will be
+ * inserted.
+ * @param data The data to be inserted.
+ */
+void list_add_before(List *list, Node *nextNode, uint16_t data) {
+    Node *prev;
+    if (nextNode == NULL || !list_find_prev(list, nextNode, &prev)) {
+        printf_red("Next node must be in the list\n");
+        return;
+    }
+    Node *newNode = list_node_new(list, data);
+    if (newNode == NULL) return;
+    list_link_after(list, prev, newNode);
+}
+
+/**
+ * Deletes the first node with the given data from the list.
+ *
+ * @param list The list.
+ * @param data The data of the node to be deleted.
+ */
+void list_remove(List *list, uint16_t data) {
+    Node *prev = NULL;
+    Node *current = list->head;
+    if (list->index) {
+        ListIndexEntry *entry = list_index_find(list->index, data);
+        current = entry ? entry->node : NULL;
+        prev = entry ? list_index_first_prev(entry) : NULL;
+    }
+    while (current != NULL && current->data != data) {
+        prev = current;
+        current = current->next;
+    }
+    if (current == NULL) return;
+
+    list_unlink_after(list, prev, current);
+    list_node_free(list, current);
+}
+
+/**
+ * Deletes a given node from the list, in constant time if the list is doubly
+ * linked.
+ *
+ * @param list The list.
+ * @param node A pointer to the node to be deleted.
+ */
+void list_remove_node(List *list, Node *node) {
+    Node *prev;
+    if (node == NULL || !list_find_prev(list, node, &prev)) {
+        printf_red("Node must be in the list\n");
+        return;
+    }
+    list_unlink_after(list, prev, node);
+    list_node_free(list, node);
+}
+
+// Nodes collected before they are handed back to the pool in one call.
+#define LIST_FREE_BATCH 64
+
+/// @brief unlinks every node for which match returns true in one pass and
+/// frees them in batches; the index, if any, is rebuilt once at the end
+/// @param list
+/// @param match
+/// @param ctx passed to match
+/// @return the number of nodes deleted
+static size_t list_delete_matching(List *list, bool (*match)(uint16_t, const void *), const void *ctx) {
+    // Keeping the index current node by node can rescan for the next
+    // occurrence of a value on every unlink
+    ListIndex *index = list->index;
+    list->index = NULL;
+
+    void *batch[LIST_FREE_BATCH];
+    size_t pending = 0;
+    size_t deleted = 0;
+    Node *prev = NULL;
+    Node *current = list->head;
+    while (current != NULL) {
+        Node *next = current->next;
+        if (match(current->data, ctx)) {
+            list_unlink_after(list, prev, current);
+            batch[pending++] = current;
+            deleted++;
+            if (pending == LIST_FREE_BATCH) {
+                list_pool_free_batch(list, batch, pending);
+                pending = 0;
+            }
+        } else {
+            prev = current;
+        }
+        current = next;
+    }
+    list_pool_free_batch(list, batch, pending);
+
+    list->index = index;
+    if (index && deleted && !list_index_rebuild(list)) {
+        printf_red("%s,%d No room to rebuild the list index, disabling it\n", __FILE__, __LINE__);
+        list_index_disable(list);
+    }
+    return deleted;
+}
+
+/// @brief matches one value
+/// @param data
+/// @param ctx the value
+static bool list_match_value(uint16_t data, const void *ctx) {
+    return data == *(const uint16_t *)ctx;
+}
+
+// Adapts a public predicate to list_delete_matching.
+typedef struct ListPredicateCall {
+    ListPredicate predicate;
+    void *ctx;
+} ListPredicateCall;
+
+/// @brief calls a public predicate
+/// @param data
+/// @param ctx a ListPredicateCall
+static bool list_match_predicate(uint16_t data, const void *ctx) {
+    const ListPredicateCall *call = (const ListPredicateCall *)ctx;
+    return call->predicate(data, call->ctx);
+}
+
+/// @brief matches the values of a bit set with one bit per uint16_t value
+/// @param data
+/// @param ctx the bit set
+static bool list_match_set(uint16_t data, const void *ctx) {
+    const uint64_t *set = (const uint64_t *)ctx;
+    return (set[data >> 6] >> (data & 63)) & 1;
+}
+
+/**
+ * Deletes every node with the given data in a single pass.
+ *
+ * @param list The list.
+ * @param data The data of the nodes to be deleted.
+ * @return The number of nodes deleted.
+ */
+size_t list_delete_all(List *list, uint16_t data) {
+    return list_delete_matching(list, list_match_value, &data);
+}
+
+/**
+ * Deletes every node for which a predicate returns true, in a single pass.
+ * The predicate must not modify the list.
+ *
+ * @param list The list.
+ * @param predicate Called with the data of each node and ctx.
+ * @param ctx Passed to the predicate.
+ * @return The number of nodes deleted.
+ */
+size_t list_delete_if(List *list, ListPredicate predicate, void *ctx) {
+    ListPredicateCall call = {predicate, ctx};
+    return list_delete_matching(list, list_match_predicate, &call);
+}
+
+/**
+ * Deletes every node whose data is one of the given values, in a single pass.
+ * The values are gathered into a bit set first, so each node costs one
+ * lookup however many values there are.
+ *
+ * @param list The list.
+ * @param values The values to delete. Repeated values are allowed.
+ * @param n The number of values.
+ * @return The number of nodes deleted.
+ */
+size_t list_delete_values(List *list, const uint16_t *values, size_t n) {
+    uint64_t set[(UINT16_MAX + 1) / 64] = {0};
+    for (size_t i = 0; i < n; i++) set[values[i] >> 6] |= (uint64_t)1 << (values[i] & 63);
+    return list_delete_matching(list, list_match_set, set);
+}
+
+/**
+ * Searches for the first node with the given data in the list.
+ *
+ * @param list The list.
+ * @param data The data to search for.
+ * @return A pointer to the node with the given data, or NULL if not found.
+ */
+Node *list_find(List *list, uint16_t data) {
+    if (list->index) {
+        ListIndexEntry *entry = list_index_find(list->index, data);
+        return entry ? entry->node : NULL;
+    }
+    return list_search(&list->head, data);
+}
+
+/**
+ * Returns the node before a given node, for walking a list backwards from
+ * its tail. Takes constant time if the list is doubly linked, and walks from
+ * the head otherwise.
+ *
+ * @param list The list.
+ * @param node A pointer to a node in the list.
+ * @return The previous node, or NULL if node is the head.
+ */
+Node *list_prev(List *list, Node *node) {
+    Node *prev = NULL;
+    if (node) list_find_prev(list, node, &prev);
+    return prev;
+}
+
+/**
+ * Displays the entire list.
+ *
+ * @param list The list.
+ */
+void list_print(List *list) {
+    list_display(&list->head);
+}
+
+/**
+ * Displays a selected range of the list.
+ *
+ * @param list The list.
+ * @param startNode A pointer to the starting node of the range.
+ * @param endNode A pointer to the ending node of the range.
+ */
+void list_print_range(List *list, Node *startNode, Node *endNode) {
+    list_display_range(&list->head, startNode, endNode);
+}
+
+/**
+ * Displays the entire list from the tail to the head, in the format of
+ * list_print. Takes linear time: doubly linked lists are walked backwards,
+ * and singly linked lists are walked forward once into a temporary buffer.
+ *
+ * @param list The list.
+ */
+void list_print_reverse(List *list) {
+    list_format_to_sink(list->head, NULL, NULL, true, list, list_flush_file, stdout);
+}
+
+/**
+ * Returns the number of nodes in the list in constant time.
+ *
+ * @param list The list.
+ * @return The number of nodes in the list.
+ */
+size_t list_length(List *list) {
+    return list->count;
+}
+
+// State of list_for_each_chunk across chunks.
+typedef struct ListForEach {
+    ListVisitor fn;
+    void *ctx;
+} ListForEach;
+
+/// @brief chunk visitor that calls a per-value visitor
+/// @param values
+/// @param n
+/// @param ctx a ListForEach
+static void list_for_each_chunk(const uint16_t *values, size_t n, void *ctx) {
+    ListForEach *each = (ListForEach *)ctx;
+    for (size_t i = 0; i < n; i++) each->fn(values[i], each->ctx);
+}
+
+/**
+ * Calls a function with every value of the list, first to last. Nodes are
+ * prefetched a few hops ahead of the one being visited.
+ *
+ * @param list The list.
+ * @param fn The function to call. It must not change the list.
+ * @param ctx Passed to fn.
+ */
+void list_for_each(List *list, ListVisitor fn, void *ctx) {
+    ListForEach each = {fn, ctx};
+    list_walk_chunks(list->head, NULL, list_for_each_chunk, &each);
+}
+
+/**
+ * Calls a function with the values of the list, first to last, in arrays of
+ * up to 256 consecutive values, so that per-value work can run over plain
+ * arrays. Nodes are prefetched a few hops ahead of the walk.
+ *
+ * @param list The list.
+ * @param fn The function to call. It must not change the list.
+ * @param ctx Passed to fn.
+ */
+void list_visit_chunks(List *list, ListChunkVisitor fn, void *ctx) {
+    list_walk_chunks(list->head, NULL, fn, ctx);
+}
+
+/**
+ * Frees all nodes of the list and the memory pool it was created with:
+ * the default pool if list_create set it up, or the list's own pool, in
+ * constant time, for list_create_pool. A pool passed to list_create_in, or a
+ * default pool that was already in use, stays.
+ *
+ * @param list The list.
+ */
+void list_destroy(List *list) {
+    if (list->ownsPool && list->pool != NULL) {
+        mem_pool_destroy(list->pool);
+    } else {
+        list_index_disable(list);
+        Node *current = list->head;
+        while (current != NULL) {
+            Node *next = current->next;
+            list_node_free(list, current);
+            current = next;
+        }
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    list->index = NULL;
+    if (list->ownsPool && list->pool == NULL) mem_deinit();
+    list->pool = NULL;
+    list->ownsPool = false;
+}
+
+/// @brief merges two sorted chains, taking from a first on ties
+/// @param a
+/// @param b
+/// @return the merged chain
+static Node *list_merge_chains(Node *a, Node *b) {
+    Node head;
+    Node *tail = &head;
+    while (a != NULL && b != NULL) {
+        if (b->data < a->data) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = (a != NULL) ? a : b;
+    return head.next;
+}
+
+/// @brief stable bottom-up merge sort of a chain; bins[i] holds a sorted run
+/// of 2^i nodes, like the digits of a binary counter
+/// @param head
+/// @return the sorted chain
+static Node *list_merge_sort(Node *head) {
+    Node *bins[64] = {NULL};
+    while (head != NULL) {
+        Node *run = head;
+        head = head->next;
+        run->next = NULL;
+        int i = 0;
+        for (; i < 63 && bins[i] != NULL; i++) {
+            run = list_merge_chains(bins[i], run);
+            bins[i] = NULL;
+        }
+        bins[i] = list_merge_chains(bins[i], run);
+    }
+    // Lower bins hold later nodes
+    Node *sorted = NULL;
+    for (int i = 0; i < 64; i++) sorted = list_merge_chains(bins[i], sorted);
+    return sorted;
+}
+
+/// @brief rewrites the values of a list in ascending order from a histogram
+/// @param list
+/// @return false if there is no memory for the histogram
+static bool list_counting_sort(List *list) {
+    size_t *counts = calloc(UINT16_MAX + 1, sizeof(size_t));
+    if (counts == NULL) return false;
+    for (Node *current = list->head; current != NULL; current = current->next) counts[current->data]++;
+
+    Node *current = list->head;
+    for (size_t value = 0; value <= UINT16_MAX; value++) {
+        for (size_t k = counts[value]; k > 0; k--) {
+            current->data = (uint16_t)value;
+            current = current->next;
+        }
+    }
+    free(counts);
+    return true;
+}
+
+/**
+ * Sorts the list in ascending order.
+ *
+ * LIST_SORT_MERGE relinks the nodes with a bottom-up merge sort in
+ * O(n log n) time and no allocation; nodes with equal values keep their
+ * order, so pointers to nodes still refer to the same values.
+ *
+ * LIST_SORT_COUNTING counts each of the 65536 possible values and rewrites
+ * the values in place in O(n) time, leaving the links alone. Node pointers
+ * then refer to whatever value ends up in that position. It falls back to
+ * merge sort if the 512 KiB histogram cannot be allocated.
+ *
+ * @param list The list.
+ * @param mode LIST_SORT_MERGE or LIST_SORT_COUNTING.
+ */
+void list_sort(List *list, ListSortMode mode) {
+    if (list->count < 2) return;
+
+    if (mode != LIST_SORT_COUNTING || !list_counting_sort(list)) {
+        list->head = list_merge_sort(list->head);
+        // One pass to find the tail and restore prev pointers
+        Node *prev = NULL;
+        for (Node *current = list->head; current != NULL; prev = current, current = current->next) {
+            if (list->flags & LIST_DOUBLY) ((DNode *)current)->prev = (DNode *)prev;
+        }
+        list->tail = prev;
+    }
+
+    if (list->index && !list_index_rebuild(list)) {
+        printf_red("%s,%d No room to rebuild the list index, disabling it\n", __FILE__, __LINE__);
+        list_index_disable(list);
+    }
+}
+
+// Sorted set operations switch from walking the other list to probing a value
+// index once one side is this many times longer than the other.
+#define LIST_PROBE_RATIO 16
+
+/// @brief whether the nodes of other can be linked into list: they must come
+/// from the same pool and be of the same kind
+/// @param list
+/// @param other
+/// @return
+static bool list_can_relink(List *list, List *other) {
+    return list != other && list->pool == other->pool && (list->flags & LIST_DOUBLY) == (other->flags & LIST_DOUBLY);
+}
+
+/// @brief restores the tail, count and prev pointers of a list whose chain
+/// was relinked from list->head, and rebuilds its index
+/// @param list
+static void list_relinked(List *list) {
+    size_t count = 0;
+    Node *prev = NULL;
+    for (Node *current = list->head; current != NULL; prev = current, current = current->next) {
+        if (list->flags & LIST_DOUBLY) ((DNode *)current)->prev = (DNode *)prev;
+        count++;
+    }
+    list->tail = prev;
+    list->count = count;
+    if (list->index && !list_index_rebuild(list)) {
+        printf_red("%s,%d No room to rebuild the list index, disabling it\n", __FILE__, __LINE__);
+        list_index_disable(list);
+    }
+}
+
+/// @brief keeps the nodes of a sorted list that are matched, or unmatched, by
+/// nodes of a sorted other list, pairing equal values one to one, and frees
+/// the rest in batches; other is walked alongside, or probed through its
+/// index when it is much longer
+/// @param list
+/// @param other
+/// @param keepMatched true to intersect, false to subtract
+/// @return the number of nodes deleted
+static size_t list_filter_sorted(List *list, List *other, bool keepMatched) {
+    bool probe = other->index != NULL && other->count / LIST_PROBE_RATIO > list->count;
+    ListIndex *index = list->index;
+    list->index = NULL;
+
+    void *batch[LIST_FREE_BATCH];
+    size_t pending = 0;
+    size_t deleted = 0;
+    Node head = {.next = NULL};
+    Node *tail = &head;
+    Node *b = other->head;
+    ListIndexEntry *entry = NULL;
+    size_t matched = 0;
+    for (Node *a = list->head, *next; a != NULL; a = next) {
+        next = a->next;
+        bool match;
+        if (probe) {
+            // Equal values are adjacent, so a run of a value pairs with its
+            // count in other
+            if (entry == NULL || entry->value != a->data) {
+                entry = list_index_find(other->index, a->data);
+                matched = 0;
+            }
+            match = entry != NULL && matched < entry->count;
+            matched += match;
+        } else {
+            while (b != NULL && b->data < a->data) b = b->next;
+            match = b != NULL && b->data == a->data;
+            if (match) b = b->next;
+        }
+
+        if (match == keepMatched) {
+            tail->next = a;
+            tail = a;
+        } else {
+            batch[pending++] = a;
+            deleted++;
+            if (pending == LIST_FREE_BATCH) {
+                list_pool_free_batch(list, batch, pending);
+                pending = 0;
+            }
+        }
+    }
+    tail->next = NULL;
+    list_pool_free_batch(list, batch, pending);
+
+    list->head = head.next;
+    list->index = index;
+    if (deleted) list_relinked(list);
+    return deleted;
+}
+
+/// @brief unlinks from a sorted, indexed list one node per node of a much
+/// shorter sorted other list, finding each through the index
+/// @param list
+/// @param other
+/// @return the number of nodes deleted
+static size_t list_subtract_probe(List *list, List *other) {
+    void *batch[LIST_FREE_BATCH];
+    size_t pending = 0;
+    size_t deleted = 0;
+    for (Node *b = other->head; b != NULL; b = b->next) {
+        // Unlinking updates the index, so the next equal node is found next
+        ListIndexEntry *entry = list_index_find(list->index, b->data);
+        if (entry == NULL) continue;
+        Node *node = entry->node;
+        list_unlink_after(list, list_index_first_prev(entry), node);
+        batch[pending++] = node;
+        deleted++;
+        if (pending == LIST_FREE_BATCH) {
+            list_pool_free_batch(list, batch, pending);
+            pending = 0;
+        }
+    }
+    list_pool_free_batch(list, batch, pending);
+    return deleted;
+}
+
+/**
+ * Merges a sorted list into another sorted list in linear time, relinking
+ * the nodes of other into list without allocating. Equal values keep their
+ * order, those of list first. other is left empty.
+ *
+ * Both lists must be sorted in ascending order, for example by list_sort,
+ * and take their nodes from the same pool, through list_create_in.
+ *
+ * @param list The list that receives the nodes.
+ * @param other Another list whose nodes are moved.
+ * @return true on success, false if the lists do not share a pool or do not
+ * have the same flags; both are unchanged then.
+ */
+bool list_merge(List *list, List *other) {
+    if (!list_can_relink(list, other)) return false;
+    list->head = list_merge_chains(list->head, other->head);
+    other->head = NULL;
+    list_relinked(list);
+    list_relinked(other);
+    return true;
+}
+
+/**
+ * Makes a sorted list the union of itself and another sorted list, in linear
+ * time. A value that is n times in list and m times in other ends up
+ * max(n, m) times in list. Nodes of other are relinked into list where a
+ * value is missing and freed otherwise, so other is left empty.
+ *
+ * Both lists must be sorted in ascending order and take their nodes from the
+ * same pool, through list_create_in.
+ *
+ * @param list The list that receives the union.
+ * @param other Another list whose nodes are moved or freed.
+ * @return true on success, false if the lists do not share a pool or do not
+ * have the same flags; both are unchanged then.
+ */
+bool list_union(List *list, List *other) {
+    if (!list_can_relink(list, other)) return false;
+
+    void *batch[LIST_FREE_BATCH];
+    size_t pending = 0;
+    Node head = {.next = NULL};
+    Node *tail = &head;
+    Node *a = list->head;
+    Node *b = other->head;
+    while (a != NULL && b != NULL) {
+        if (b->data < a->data) {
+            tail->next = b;
+            tail = b;
+            b = b->next;
+            continue;
+        }
+        if (b->data == a->data) {
+            // Pair the nodes; the one of other is not needed
+            batch[pending++] = b;
+            b = b->next;
+            if (pending == LIST_FREE_BATCH) {
+                list_pool_free_batch(other, batch, pending);
+                pending = 0;
+            }
+        }
+        tail->next = a;
+        tail = a;
+        a = a->next;
+    }
+    tail->next = (a != NULL) ? a : b;
+    list_pool_free_batch(other, batch, pending);
+
+    list->head = head.next;
+    other->head = NULL;
+    list_relinked(list);
+    list_relinked(other);
+    return true;
+}
+
+/**
+ * Keeps only the nodes of a sorted list whose values are also in another
+ * sorted list, in linear time, and frees the others. A value that is n times
+ * in list and m times in other ends up min(n, m) times in list. other is not
+ * changed.
+ *
+ * If other has a value index and is much longer than list, it is probed
+ * through the index instead of walked, so the cost depends on list only.
+ *
+ * @param list The sorted list to filter.
+ * @param other Another sorted list. It may use any pool.
+ * @return The number of nodes deleted.
+ */
+size_t list_intersect(List *list, List *other) {
+    return list_filter_sorted(list, other, true);
+}
+
+/**
+ * Deletes from a sorted list the values of another sorted list, in linear
+ * time. A value that is n times in list and m times in other ends up
+ * n - m times in list, or not at all. other is not changed.
+ *
+ * If list has a value index and is much longer than other, each value of
+ * other is found through the index, so the cost depends on other only. If
+ * instead other has an index and is much longer, it is probed rather than
+ * walked.
+ *
+ * @param list The sorted list to filter.
+ * @param other Another sorted list. It may use any pool.
+ * @return The number of nodes deleted.
+ */
+size_t list_difference(List *list, List *other) {
+    if (list->index != NULL && list->count / LIST_PROBE_RATIO > other->count) return list_subtract_probe(list, other);
+    return list_filter_sorted(list, other, false);
+}
+
+/**
+ * Moves the next nodes of a list, in traversal order, into one fresh
+ * contiguous pool block, and frees the old nodes. Calling it repeatedly
+ * compacts a list in bounded steps; the list must not change between
+ * steps, other than through list_compact_step itself.
+ *
+ * Pointers to moved nodes become invalid. The value index, if enabled, is
+ * updated as nodes move.
+ *
+ * @param list The list.
+ * @param cursor The last node already compacted, NULL before the first step.
+ * Updated to the last node moved; the list is compacted once it equals
+ * list->tail.
+ * @param maxNodes The most nodes to move in this step.
+ * @return true on success, false if the pool has no free run for the nodes
+ * of this step, in which case nothing is moved.
+ */
+bool list_compact_step(List *list, Node **cursor, size_t maxNodes) {
+    Node *before = *cursor;
+    Node *first = before ? before->next : list->head;
+    size_t count = 0;
+    for (Node *current = first; current != NULL && count < maxNodes; current = current->next) count++;
+    if (count == 0) return true;
+
+    size_t size = (list->flags & LIST_DOUBLY) ? sizeof(DNode) : sizeof(Node);
+    char *block = (char *)list_pool_alloc_batch(list, size, count);
+    if (block == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc_batch()\n", __FILE__, __LINE__);
+        return false;
+    }
+
+    void *batch[LIST_FREE_BATCH];
+    size_t pending = 0;
+    Node *old = first;
+    Node *prev = before;
+    for (size_t i = 0; i < count; i++) {
+        Node *node = (Node *)(block + i * size);
+        Node *oldNext = old->next;
+        node->data = old->data;
+        node->order = old->order;
+        node->next = (i + 1 < count) ? (Node *)(block + (i + 1) * size) : oldNext;
+        if (list->flags & LIST_DOUBLY) ((DNode *)node)->prev = (DNode *)prev;
+        if (list->index) {
+            ListIndexEntry *entry = list_index_find(list->index, node->data);
+            if (!entry->many) {
+                entry->node = node;
+                entry->prev = prev;
+            } else {
+                ListOccurrence *item = &entry->more->items[list_index_search(entry->more, old)];
+                item->node = node;
+                item->prev = prev;
+                if (entry->node == old) entry->node = node;
+            }
+        }
+        if (list->tail == old) list->tail = node;
+
+        batch[pending++] = old;
+        if (pending == LIST_FREE_BATCH) {
+            list_pool_free_batch(list, batch, pending);
+            pending = 0;
+        }
+        prev = node;
+        old = oldNext;
+    }
+    list_pool_free_batch(list, batch, pending);
+
+    // Link the block in, and point the node after it back at it
+    if (before) {
+        before->next = (Node *)block;
+    } else {
+        list->head = (Node *)block;
+    }
+    Node *after = prev->next;
+    if (after != NULL) {
+        if (list->flags & LIST_DOUBLY) ((DNode *)after)->prev = (DNode *)prev;
+        if (list->index) *list_index_prev_of(list->index, after) = prev;
+    }
+    *cursor = prev;
+    return true;
+}
+
+/**
+ * Moves all nodes of a list, in traversal order, into one fresh contiguous
+ * pool block and frees the old ones, so that walking the list reads memory
+ * sequentially again. Pointers to nodes become invalid.
+ *
+ * @param list The list.
+ * @return true on success, false if the pool has no free run for all nodes,
+ * in which case the list is unchanged. list_compact_step needs less room.
+ */
+bool list_compact(List *list) {
+    Node *cursor = NULL;
+    return list_compact_step(list, &cursor, SIZE_MAX);
+}
+
+// Values are written and checksummed in chunks of this many.
+#define LIST_SAVE_CHUNK 8192
+
+/// @brief continues a 32-bit FNV-1a hash over some bytes
+/// @param hash the hash so far, LIST_FILE_CHECKSUM_SEED to start
+/// @param data
+/// @param length
+/// @return the new hash
+static uint32_t list_checksum(uint32_t hash, const void *data, size_t length) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Saves the values of a list to a file descriptor in the binary list format:
+ * a ListFileHeader followed by the values as a packed uint16_t array, in list
+ * order and host byte order. The values are streamed in chunks, so the file
+ * descriptor may be a pipe or socket.
+ *
+ * @param list The list.
+ * @param fd The file descriptor, positioned where the data should go.
+ * @return true on success, false if a write failed.
+ */
+bool list_save(List *list, int fd) {
+    uint16_t chunk[LIST_SAVE_CHUNK];
+    size_t used = 0;
+
+    // The checksum goes in the header, so the values are walked twice
+    uint32_t checksum = LIST_FILE_CHECKSUM_SEED;
+    for (Node *current = list->head; current != NULL; current = current->next) {
+        chunk[used++] = current->data;
+        if (used == LIST_SAVE_CHUNK) {
+            checksum = list_checksum(checksum, chunk, sizeof(chunk));
+            used = 0;
+        }
+    }
+    checksum = list_checksum(checksum, chunk, used * sizeof(uint16_t));
+
+    ListFileHeader header = {
+        .magic = LIST_FILE_MAGIC,
+        .version = LIST_FILE_VERSION,
+        .count = list->count,
+        .checksum = checksum,
+    };
+    if (!list_write_all(fd, &header, sizeof(header))) return false;
+
+    used = 0;
+    for (Node *current = list->head; current != NULL; current = current->next) {
+        chunk[used++] = current->data;
+        if (used == LIST_SAVE_CHUNK) {
+            if (!list_write_all(fd, chunk, sizeof(chunk))) return false;
+            used = 0;
+        }
+    }
+    return list_write_all(fd, chunk, used * sizeof(uint16_t));
+}
+
+/// @brief reads exactly length bytes, retrying short reads
+/// @param fd
+/// @param data
+/// @param length
+/// @return false on an error or early end of file
+static bool list_read_all(int fd, void *data, size_t length) {
+    char *next = (char *)data;
+    while (length > 0) {
+        ssize_t got = read(fd, next, length);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        next += got;
+        length -= got;
+    }
+    return true;
+}
+
+/// @brief checks the magic number and version of a header
+/// @param header
+/// @return true if the header is one list_load understands
+static bool list_file_header_valid(const ListFileHeader *header) {
+    if (header->magic == LIST_FILE_MAGIC && header->version == LIST_FILE_VERSION) return true;
+    printf_red("%s,%d Not a list file of version %d\n", __FILE__, __LINE__, LIST_FILE_VERSION);
+    return false;
+}
+
+/// @brief checks a header and the values that follow it
+/// @param header
+/// @param values
+/// @return true if both are valid
+static bool list_file_valid(const ListFileHeader *header, const uint16_t *values) {
+    if (!list_file_header_valid(header)) return false;
+    if (list_checksum(LIST_FILE_CHECKSUM_SEED, values, header->count * sizeof(uint16_t)) != header->checksum) {
+        printf_red("%s,%d List file checksum mismatch\n", __FILE__, __LINE__);
+        return false;
+    }
+    return true;
+}
+
+/// @brief reads a list file from the current position of a file descriptor
+/// in chunks, appending each chunk as it is checksummed, so that no more than
+/// a chunk is buffered whatever count the header claims; the nodes appended
+/// are taken out again on failure
+/// @param list
+/// @param fd
+/// @return true if the list file was read whole, was valid and fit the pool
+static bool list_load_stream(List *list, int fd) {
+    ListFileHeader header;
+    if (!list_read_all(fd, &header, sizeof(header)) || !list_file_header_valid(&header)) return false;
+
+    Node *last = list->tail;
+    uint16_t chunk[LIST_SAVE_CHUNK];
+    uint32_t checksum = LIST_FILE_CHECKSUM_SEED;
+    bool loaded = true;
+    for (uint64_t left = header.count; left > 0 && loaded;) {
+        size_t n = left < LIST_SAVE_CHUNK ? left : LIST_SAVE_CHUNK;
+        loaded = list_read_all(fd, chunk, n * sizeof(uint16_t)) && list_append_array(list, chunk, n);
+        checksum = list_checksum(checksum, chunk, n * sizeof(uint16_t));
+        left -= n;
+    }
+    if (loaded && checksum != header.checksum) {
+        printf_red("%s,%d List file checksum mismatch\n", __FILE__, __LINE__);
+        loaded = false;
+    }
+
+    if (!loaded) {
+        Node *node = last ? last->next : list->head;
+        while (node != NULL) {
+            Node *next = node->next;
+            list_unlink_after(list, last, node);
+            list_node_free(list, node);
+            node = next;
+        }
+    }
+    return loaded;
+}
+
+/**
+ * Loads values saved with list_save from the current position of a file
+ * descriptor and appends them to a list, leaving the position after them.
+ * A regular file is mapped rather than read, and all nodes are built in one
+ * contiguous pool block, as list_append_array does, in a single pass over
+ * the values. Other file descriptors, such as pipes, are read in chunks of
+ * values, each built into a contiguous block.
+ *
+ * @param list The list, created with room for the values.
+ * @param fd The file descriptor of a file written by list_save.
+ * @return true on success, false if the data is not a valid list file, the
+ * checksum does not match, or the pool has no room. The list is unchanged
+ * on failure, and so is the position if the file descriptor is seekable;
+ * otherwise the data read before the failure is consumed.
+ */
+bool list_load(List *list, int fd) {
+    struct stat info;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    // Map only where the header would be aligned
+    if (offset >= 0 && offset % sizeof(uint64_t) == 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+        info.st_size - offset >= (off_t)sizeof(ListFileHeader)) {
+        // Map from the page holding the current position
+        off_t base = offset & ~((off_t)sysconf(_SC_PAGESIZE) - 1);
+        size_t length = info.st_size - base;
+        char *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, base);
+        if (map != MAP_FAILED) {
+            const ListFileHeader *header = (const ListFileHeader *)(map + (offset - base));
+            const uint16_t *values = (const uint16_t *)(header + 1);
+            size_t available = (info.st_size - offset - sizeof(ListFileHeader)) / sizeof(uint16_t);
+            bool loaded = false;
+            if (header->count > available) {
+                printf_red("%s,%d List file is shorter than its count\n", __FILE__, __LINE__);
+            } else if (list_file_valid(header, values)) {
+                loaded = list_append_array(list, values, header->count);
+            }
+            // Leave the position after the list, as reading it would
+            if (loaded) lseek(fd, offset + sizeof(ListFileHeader) + header->count * sizeof(uint16_t), SEEK_SET);
+            munmap(map, length);
+            return loaded;
+        }
+    }
+
+    if (list_load_stream(list, fd)) return true;
+    // Go back to where the list file started, as a failed mapping does
+    if (offset >= 0) lseek(fd, offset, SEEK_SET);
+    return false;
+}
+
+/**
+ * Builds an index from each value to the nodes holding it, so that
+ * list_find and list_remove take constant time instead of scanning, and the
+ * predecessor of any node is found by binary search among the nodes with its
+ * value. The index is kept in the list's pool and updated by every list
+ * operation in amortized constant time, plus a shift within the nodes of the
+ * value when a node is inserted or removed between two others with it.
+ *
+ * @param list The list.
+ * @return true if the index is enabled, false if the pool has no room for it.
+ */
+bool list_index_enable(List *list) {
+    if (list->index) return true;
+    if (list_index_rebuild(list)) return true;
+    printf_red("%s,%d Memory allocation failed in list_index_enable()\n", __FILE__, __LINE__);
+    return false;
+}
+
+/**
+ * Drops the value index of a list and returns its memory to the pool.
+ *
+ * @param list The list.
+ */
+void list_index_disable(List *list) {
+    if (list->index == NULL) return;
+    list_index_free_occurrences(list);
+    list_pool_free(list, list->index);
+    list->index = NULL;
+}
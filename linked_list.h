@@ -9,9 +9,64 @@
 
 typedef struct Node {
     uint16_t data;      // Stores the data as an unsigned 16-bit integer
+    uint32_t order;     // Position label kept by the value index of a List
     struct Node* next;  // A pointer to the next node in the List
 } Node;
 
+// A node of a doubly linked list. It starts with a Node, so code that only
+// follows next pointers walks both kinds of list alike.
+typedef struct DNode {
+    Node node;
+    struct DNode* prev;  // A pointer to the previous node in the List
+} DNode;
+
+// List flags
+#define LIST_DOUBLY 0x1u  // nodes are DNodes with a prev pointer
+
+// Algorithms for list_sort.
+typedef enum ListSortMode {
+    LIST_SORT_MERGE,     // relink nodes, stable, O(n log n), no allocation
+    LIST_SORT_COUNTING,  // rewrite values from a histogram, O(n)
+} ListSortMode;
+
+// Decides whether a value matches, for list_delete_if.
+typedef bool (*ListPredicate)(uint16_t data, void* ctx);
+
+// Receives the values of a list one at a time, for list_for_each, or as
+// arrays of consecutive values, for list_visit_chunks.
+typedef void (*ListVisitor)(uint16_t data, void* ctx);
+typedef void (*ListChunkVisitor)(const uint16_t* values, size_t n, void* ctx);
+
+// Binary list format written by list_save: this header, then count values
+// as a packed uint16_t array. The checksum is a 32-bit FNV-1a hash of the
+// value bytes. All fields are in host byte order.
+#define LIST_FILE_MAGIC 0x5453494Cu  // "LIST" in little-endian byte order
+#define LIST_FILE_VERSION 1
+#define LIST_FILE_CHECKSUM_SEED 2166136261u
+
+typedef struct ListFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t count;     // number of values
+    uint32_t checksum;  // FNV-1a of the values
+    uint32_t reserved2;
+} ListFileHeader;
+
+struct ListIndex;
+
+// A list handle. Keeps the tail and the number of nodes, so that appending
+// and counting do not have to walk the list.
+typedef struct List {
+    Node* head;               // first node, NULL when the list is empty
+    Node* tail;               // last node, NULL when the list is empty
+    size_t count;             // number of nodes
+    struct ListIndex* index;  // value index, NULL unless enabled
+    unsigned flags;           // LIST_* flags chosen at creation
+    MemPool* pool;            // pool of the nodes, NULL for the default pool
+    bool ownsPool;            // whether list_destroy releases the pool
+} List;
+
 void list_init(Node** head, size_t size);
 void list_insert(Node** head, uint16_t data);
 void list_insert_after(Node* prevNode, uint16_t data);
@@ -20,7 +75,49 @@ void list_delete(Node** head, uint16_t data);
 Node* list_search(Node** head, uint16_t data);
 void list_display(Node** head);
 void list_display_range(Node** head, Node* startNode, Node* endNode);
+size_t list_format(Node** head, char* buffer, size_t size);
+size_t list_format_range(Node** head, Node* startNode, Node* endNode, char* buffer, size_t size);
+bool list_write(Node** head, int fd);
+bool list_write_range(Node** head, Node* startNode, Node* endNode, int fd);
 int list_count_nodes(Node** head);
 void list_cleanup(Node** head);
 
-#endif
\ No newline at end of file
+void list_create(List* list, size_t size);
+void list_create_ex(List* list, size_t size, unsigned flags);
+bool list_create_pool(List* list, size_t size, unsigned flags);
+void list_create_in(List* list, MemPool* pool, unsigned flags);
+void list_append(List* list, uint16_t data);
+void list_prepend(List* list, uint16_t data);
+bool list_append_array(List* list, const uint16_t* values, size_t n);
+bool list_from_array(List* list, size_t size, const uint16_t* values, size_t n);
+void list_add_after(List* list, Node* prevNode, uint16_t data);
+void list_add_before(List* list, Node* nextNode, uint16_t data);
+void list_remove(List* list, uint16_t data);
+void list_remove_node(List* list, Node* node);
+size_t list_delete_all(List* list, uint16_t data);
+size_t list_delete_if(List* list, ListPredicate predicate, void* ctx);
+size_t list_delete_values(List* list, const uint16_t* values, size_t n);
+Node* list_find(List* list, uint16_t data);
+Node* list_prev(List* list, Node* node);
+void list_print(List* list);
+void list_print_range(List* list, Node* startNode, Node* endNode);
+void list_print_reverse(List* list);
+size_t list_length(List* list);
+void list_for_each(List* list, ListVisitor fn, void* ctx);
+void list_visit_chunks(List* list, ListChunkVisitor fn, void* ctx);
+void list_destroy(List* list);
+
+void list_sort(List* list, ListSortMode mode);
+bool list_merge(List* list, List* other);
+bool list_union(List* list, List* other);
+size_t list_intersect(List* list, List* other);
+size_t list_difference(List* list, List* other);
+bool list_compact(List* list);
+bool list_compact_step(List* list, Node** cursor, size_t maxNodes);
+bool list_save(List* list, int fd);
+bool list_load(List* list, int fd);
+
+bool list_index_enable(List* list);
+void list_index_disable(List* list);
+
+#endif
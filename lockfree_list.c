@@ -0,0 +1,382 @@
+#include "lockfree_list.h"
+
+#include <sched.h>
+
+#define LFLIST_MARK ((uintptr_t)1)
+
+/// @brief returns the node a link points to, without the deleted mark
+/// @param link
+static inline LFNode *lfnode_ptr(uintptr_t link) {
+    return (LFNode *)(link & ~LFLIST_MARK);
+}
+
+/// @brief returns nodes to the pool through the calling thread's cache
+/// @param node the first node of a chain linked through retired
+static void lfnode_free_chain(LFNode *node) {
+    while (node != NULL) {
+        LFNode *next = node->retired;
+        mem_free_small(node, sizeof(LFNode));
+        node = next;
+    }
+}
+
+/// @brief frees the limbo lists that no thread can reach any more
+/// @param thread
+/// @param epoch the current global epoch
+static void lflist_reclaim(LFThread *thread, unsigned epoch) {
+    for (int i = 0; i < 3; i++) {
+        if (thread->limbo[i] != NULL && epoch - thread->limboEpoch[i] >= 2) {
+            lfnode_free_chain(thread->limbo[i]);
+            thread->limbo[i] = NULL;
+        }
+    }
+}
+
+/// @brief advances the global epoch if every thread in a critical section
+/// has seen the current one
+/// @param list
+/// @return true if the epoch moved on since the call began
+static bool lflist_try_advance(LFList *list) {
+    unsigned epoch = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < LFLIST_MAX_THREADS; i++) {
+        LFThread *other = &list->threads[i];
+        if (!__atomic_load_n(&other->attached, __ATOMIC_SEQ_CST)) continue;
+        if (__atomic_load_n(&other->active, __ATOMIC_SEQ_CST) &&
+            __atomic_load_n(&other->epoch, __ATOMIC_SEQ_CST) != epoch)
+            return false;
+    }
+    // Failure means another thread advanced it
+    __atomic_compare_exchange_n(&list->epoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+/// @brief hands a node that was just unlinked to epoch-based reclamation
+/// @param thread the thread whose CAS unlinked the node
+/// @param node
+static void lflist_retire(LFThread *thread, LFNode *node) {
+    // Threads that can still hold the node started no later than this epoch,
+    // and have all left once the epoch has advanced twice more
+    unsigned epoch = __atomic_load_n(&thread->list->epoch, __ATOMIC_SEQ_CST);
+    int i = epoch % 3;
+    if (thread->limbo[i] != NULL && thread->limboEpoch[i] != epoch) {
+        lfnode_free_chain(thread->limbo[i]);
+        thread->limbo[i] = NULL;
+    }
+    node->retired = thread->limbo[i];
+    thread->limbo[i] = node;
+    thread->limboEpoch[i] = epoch;
+
+    // Keep trying on every retire while a thread holds the epoch back
+    if (++thread->retiredSinceAdvance >= LFLIST_RETIRE_BATCH && lflist_try_advance(thread->list)) {
+        thread->retiredSinceAdvance = 0;
+    }
+}
+
+/// @brief finds the first unmarked node with a value, unlinking the marked
+/// nodes on the way; must be called in a critical section
+/// @param thread
+/// @param data
+/// @param prevLink set to the link that points to the node
+/// @param next set to the node's next link
+/// @return the node, or NULL if the value is not in the list
+static LFNode *lflist_locate(LFThread *thread, uint16_t data, uintptr_t **prevLink, uintptr_t *next) {
+retry:;
+    uintptr_t *prev = &thread->list->head.next;
+    LFNode *current = lfnode_ptr(__atomic_load_n(prev, __ATOMIC_ACQUIRE));
+    while (current != NULL) {
+        uintptr_t link = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
+        if (link & LFLIST_MARK) {
+            // Deleted: unlink it. Failure means prev changed or was deleted.
+            uintptr_t expected = (uintptr_t)current;
+            if (!__atomic_compare_exchange_n(prev, &expected, link & ~LFLIST_MARK, false, __ATOMIC_ACQ_REL,
+                                             __ATOMIC_ACQUIRE))
+                goto retry;
+            lflist_retire(thread, current);
+            current = lfnode_ptr(link);
+            continue;
+        }
+        if (current->data == data) {
+            *prevLink = prev;
+            *next = link;
+            return current;
+        }
+        prev = &current->next;
+        current = lfnode_ptr(link);
+    }
+    return NULL;
+}
+
+/**
+ * Initializes the lock-free list and the memory pool its nodes are taken
+ * from. The pool must be able to hold the nodes of the list, nodes awaiting
+ * reclamation, and the small-allocation cache of each thread.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool.
+ */
+void lflist_init(LFList *list, size_t size) {
+    mem_init(size);
+    memset(list, 0, sizeof(*list));
+}
+
+/**
+ * Registers the calling thread with the list. Every thread must attach
+ * before its first operation on the list and use its own handle.
+ *
+ * @param list The list.
+ * @return The thread's handle, or NULL if LFLIST_MAX_THREADS threads are
+ * attached already.
+ */
+LFThread *lflist_attach(LFList *list) {
+    for (int i = 0; i < LFLIST_MAX_THREADS; i++) {
+        LFThread *thread = &list->threads[i];
+        bool expected = false;
+        if (__atomic_load_n(&thread->attached, __ATOMIC_RELAXED)) continue;
+        // Set the fields before the slot becomes visible as attached
+        thread->list = list;
+        if (!__atomic_compare_exchange_n(&thread->attached, &expected, true, false, __ATOMIC_SEQ_CST,
+                                         __ATOMIC_RELAXED))
+            continue;
+        thread->nesting = 0;
+        thread->retiredSinceAdvance = 0;
+        for (int k = 0; k < 3; k++) thread->limbo[k] = NULL;
+        return thread;
+    }
+    printf_red("%s,%d Too many threads attached to the list\n", __FILE__, __LINE__);
+    return NULL;
+}
+
+/**
+ * Unregisters a thread, after returning the nodes it retired to the pool.
+ * Waits until the threads that were in a critical section have left it.
+ *
+ * @param thread The thread's handle, outside any critical section.
+ */
+void lflist_detach(LFThread *thread) {
+    LFList *list = thread->list;
+    unsigned start = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+    unsigned epoch = start;
+    while (epoch - start < 2) {
+        if (!lflist_try_advance(list)) sched_yield();
+        epoch = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+    }
+    lflist_reclaim(thread, epoch);
+    __atomic_store_n(&thread->attached, false, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Begins a critical section. Nodes returned by lflist_find and passed to
+ * lflist_insert_after stay valid until the matching lflist_exit. The list
+ * operations enter and exit on their own; sections nest.
+ *
+ * @param thread The thread's handle.
+ */
+void lflist_enter(LFThread *thread) {
+    if (thread->nesting++ > 0) return;
+    LFList *list = thread->list;
+    unsigned epoch = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&thread->epoch, epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&thread->active, true, __ATOMIC_SEQ_CST);
+    // Publish the epoch again if it moved before active was visible
+    unsigned current = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+    while (current != epoch) {
+        epoch = current;
+        __atomic_store_n(&thread->epoch, epoch, __ATOMIC_SEQ_CST);
+        current = __atomic_load_n(&list->epoch, __ATOMIC_SEQ_CST);
+    }
+    lflist_reclaim(thread, epoch);
+}
+
+/**
+ * Ends a critical section begun with lflist_enter.
+ *
+ * @param thread The thread's handle.
+ */
+void lflist_exit(LFThread *thread) {
+    if (--thread->nesting > 0) return;
+    __atomic_store_n(&thread->active, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * Inserts a new node at the start of the list.
+ *
+ * @param thread The thread's handle.
+ * @param data The data to be inserted.
+ * @return The new node, valid while the caller is in a critical section, or
+ * NULL if the pool is full.
+ */
+LFNode *lflist_insert(LFThread *thread, uint16_t data) {
+    return lflist_insert_after(thread, &thread->list->head, data);
+}
+
+/**
+ * Inserts a new node after a given node with a single compare-and-swap,
+ * retried only while other nodes are inserted at the same place.
+ *
+ * @param thread The thread's handle.
+ * @param prevNode A node obtained in the current critical section.
+ * @param data The data to be inserted.
+ * @return The new node, or NULL if prevNode has been deleted or the pool is
+ * full.
+ */
+LFNode *lflist_insert_after(LFThread *thread, LFNode *prevNode, uint16_t data) {
+    LFNode *node = (LFNode *)mem_alloc_small(sizeof(LFNode));
+    if (node == NULL && thread->nesting == 0) {
+        // Free what this thread has retired, if the other threads allow it
+        lflist_try_advance(thread->list);
+        lflist_try_advance(thread->list);
+        lflist_reclaim(thread, __atomic_load_n(&thread->list->epoch, __ATOMIC_SEQ_CST));
+        node = (LFNode *)mem_alloc_small(sizeof(LFNode));
+    }
+    if (node == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc_small()\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    node->data = data;
+    node->retired = NULL;
+
+    lflist_enter(thread);
+    uintptr_t next = __atomic_load_n(&prevNode->next, __ATOMIC_ACQUIRE);
+    do {
+        if (next & LFLIST_MARK) {
+            // The predecessor is deleted; the new node was never visible
+            lflist_exit(thread);
+            mem_free_small(node, sizeof(LFNode));
+            return NULL;
+        }
+        node->next = next;
+    } while (!__atomic_compare_exchange_n(&prevNode->next, &next, (uintptr_t)node, true, __ATOMIC_RELEASE,
+                                          __ATOMIC_ACQUIRE));
+    lflist_exit(thread);
+    return node;
+}
+
+/**
+ * Deletes the first node with the given data. The node is marked first, which
+ * makes the deletion visible, and then unlinked by this or another thread.
+ *
+ * @param thread The thread's handle.
+ * @param data The data of the node to be deleted.
+ * @return true if a node was deleted, false if the value was not found.
+ */
+bool lflist_delete(LFThread *thread, uint16_t data) {
+    lflist_enter(thread);
+    for (;;) {
+        uintptr_t *prev;
+        uintptr_t next;
+        LFNode *node = lflist_locate(thread, data, &prev, &next);
+        if (node == NULL) {
+            lflist_exit(thread);
+            return false;
+        }
+        // Mark; fails if a node was inserted after it or another thread
+        // deleted it first
+        if (!__atomic_compare_exchange_n(&node->next, &next, next | LFLIST_MARK, false, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE))
+            continue;
+
+        uintptr_t expected = (uintptr_t)node;
+        if (__atomic_compare_exchange_n(prev, &expected, next, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            lflist_retire(thread, node);
+        } else {
+            // Someone changed prev; walk again to unlink the node
+            lflist_locate(thread, data, &prev, &next);
+        }
+        lflist_exit(thread);
+        return true;
+    }
+}
+
+/**
+ * Returns the first node with the given data. The walk never waits for, retries
+ * because of, or writes for other threads.
+ *
+ * @param thread The thread's handle, inside a critical section.
+ * @param data The data to search for.
+ * @return The node, valid until the critical section ends, or NULL.
+ */
+LFNode *lflist_find(LFThread *thread, uint16_t data) {
+    LFNode *current = lfnode_ptr(__atomic_load_n(&thread->list->head.next, __ATOMIC_ACQUIRE));
+    while (current != NULL) {
+        uintptr_t link = __atomic_load_n(&current->next, __ATOMIC_ACQUIRE);
+        if (!(link & LFLIST_MARK) && current->data == data) return current;
+        current = lfnode_ptr(link);
+    }
+    return NULL;
+}
+
+/**
+ * Checks whether a value is in the list, without waiting for other threads.
+ *
+ * @param thread The thread's handle.
+ * @param data The data to search for.
+ * @return true if an undeleted node holds the value.
+ */
+bool lflist_search(LFThread *thread, uint16_t data) {
+    lflist_enter(thread);
+    bool found = lflist_find(thread, data) != NULL;
+    lflist_exit(thread);
+    return found;
+}
+
+/**
+ * Counts the undeleted nodes. Only meaningful while no thread deletes.
+ *
+ * @param list The list.
+ * @return The number of nodes.
+ */
+size_t lflist_count_nodes(LFList *list) {
+    size_t count = 0;
+    for (LFNode *current = lfnode_ptr(list->head.next); current != NULL; current = lfnode_ptr(current->next)) {
+        if (!(current->next & LFLIST_MARK)) count++;
+    }
+    return count;
+}
+
+/**
+ * Displays the undeleted nodes of the list. Only safe while no thread
+ * deletes.
+ *
+ * @param list The list.
+ */
+void lflist_display(LFList *list) {
+    LFNode *current = lfnode_ptr(list->head.next);
+    if (current == NULL) {
+        printf("NULL");
+        return;
+    }
+
+    printf("[");
+    bool separator = false;
+    for (; current != NULL; current = lfnode_ptr(current->next)) {
+        if (current->next & LFLIST_MARK) continue;
+        printf(separator ? ", %d" : "%d", current->data);
+        separator = true;
+    }
+    printf("]");
+}
+
+/**
+ * Frees all nodes, including those awaiting reclamation, and the memory
+ * pool. No thread may use the list any more.
+ *
+ * @param list The list.
+ */
+void lflist_cleanup(LFList *list) {
+    LFNode *current = lfnode_ptr(list->head.next);
+    while (current != NULL) {
+        LFNode *next = lfnode_ptr(current->next);
+        mem_free(current);
+        current = next;
+    }
+    for (int i = 0; i < LFLIST_MAX_THREADS; i++) {
+        for (int k = 0; k < 3; k++) {
+            for (LFNode *node = list->threads[i].limbo[k], *next; node != NULL; node = next) {
+                next = node->retired;
+                mem_free(node);
+            }
+        }
+    }
+    memset(list, 0, sizeof(*list));
+    mem_deinit();
+}
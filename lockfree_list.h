@@ -0,0 +1,64 @@
+#ifndef LOCKFREE_LIST_H
+#define LOCKFREE_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "common_defs.h"
+#include "memory_manager.h"
+
+// Threads that may use one list at the same time.
+#define LFLIST_MAX_THREADS 64
+// Nodes a thread retires between attempts to advance the epoch.
+#define LFLIST_RETIRE_BATCH 64
+
+// A node of a lock-free list. The low bit of next marks the node as deleted;
+// a marked node is unlinked by whichever thread next walks past it.
+typedef struct LFNode {
+    uintptr_t next;           // next node, with the deleted mark in bit 0
+    struct LFNode* retired;   // link in a limbo list once unlinked
+    uint16_t data;            // Stores the data as an unsigned 16-bit integer
+} LFNode;
+
+struct LFList;
+
+// Per-thread state for epoch-based reclamation. Unlinked nodes wait in the
+// limbo list of the epoch they were retired in until no thread can still
+// hold them, and then go back to the pool. Each sits in its own cache line,
+// since its thread writes it on every operation.
+typedef struct __attribute__((aligned(64))) LFThread {
+    struct LFList* list;
+    unsigned epoch;            // global epoch when the critical section began
+    bool active;               // inside a critical section
+    bool attached;             // slot in use
+    unsigned nesting;          // depth of lflist_enter calls
+    LFNode* limbo[3];          // retired nodes, by epoch modulo 3
+    unsigned limboEpoch[3];    // epoch of the nodes in each limbo list
+    size_t retiredSinceAdvance;
+} LFThread;
+
+// A list that any number of attached threads may search and modify at once
+// without locks. Nodes are taken from the pool through the per-thread
+// small-allocation cache.
+typedef struct LFList {
+    LFNode head;              // sentinel, holds no value
+    unsigned epoch;           // global epoch
+    LFThread threads[LFLIST_MAX_THREADS];
+} LFList;
+
+void lflist_init(LFList* list, size_t size);
+LFThread* lflist_attach(LFList* list);
+void lflist_detach(LFThread* thread);
+void lflist_enter(LFThread* thread);
+void lflist_exit(LFThread* thread);
+LFNode* lflist_insert(LFThread* thread, uint16_t data);
+LFNode* lflist_insert_after(LFThread* thread, LFNode* prevNode, uint16_t data);
+bool lflist_delete(LFThread* thread, uint16_t data);
+bool lflist_search(LFThread* thread, uint16_t data);
+LFNode* lflist_find(LFThread* thread, uint16_t data);
+size_t lflist_count_nodes(LFList* list);
+void lflist_display(LFList* list);
+void lflist_cleanup(LFList* list);
+
+#endif
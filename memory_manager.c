@@ -1,9 +1,111 @@
+#define _GNU_SOURCE // mremap
 #include "memory_manager.h"
 
-void* memoryPool = NULL;
-size_t memorySize = 0;
-unsigned char* start = NULL;
-unsigned char* end = NULL;
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Side table for blocks that live in their own mapping instead of the pool.
+typedef struct HugeBlock {
+    void* addr;     // NULL when the slot is unused
+    size_t length;  // mapped length, rounded up to whole pages
+} HugeBlock;
+
+static HugeBlock hugeBlocks[MEM_HUGE_SLOTS];
+static size_t hugeThreshold = MEM_HUGE_THRESHOLD;
+
+// Hints that let mem_alloc skip work. Kept exact enough by the foreground
+// paths to stay correct, and tightened by the scavenger thread.
+typedef struct PoolSummary {
+    size_t firstFree;    // every byte below is allocated; always a block boundary
+    size_t largestFree;  // upper bound on the longest run of free bytes
+    size_t frees;        // number of frees so far, to detect stale scans
+    size_t allocs;       // number of runs handed out so far, likewise
+} PoolSummary;
+
+#define POOL_FILE_MAGIC 0x4c4f4f504d454d31ull  // "1MEMPOOL"
+#define POOL_FILE_VERSION 4
+
+// First page of a file-backed or shared pool. Everything after it is addressed
+// by offsets from the start of the mapping, so the pool can be mapped at a
+// different address in every process.
+typedef struct PoolHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t ready;        // set by the creator once the header is complete
+    uint64_t poolSize;
+    uint64_t startOffset;  // allocation start bitmap
+    uint64_t endOffset;    // allocation end bitmap
+    uint64_t poolOffset;   // first byte of the pool
+    uint64_t root;         // pool offset of the user's root object
+    uint64_t checkpoints;  // number of completed mem_checkpoint calls
+    pthread_mutex_t lock;  // process-shared, guards the bitmaps and summary
+    PoolSummary summary;
+} PoolHeader;
+
+// A region that blocks are handed out from, with the bitmaps that mark where
+// each block starts and ends. The default pool serves mem_alloc and friends
+// and is the only one that can be file-backed, shared or scavenged; more are
+// made with mem_pool_create.
+struct MemPool {
+    void* memory;
+    size_t size;
+    unsigned char* start;    // allocation start bitmap
+    unsigned char* end;      // allocation end bitmap
+    PoolSummary* summary;
+    pthread_mutex_t* lock;
+    // Where summary and lock point, except in the default pool
+    PoolSummary ownSummary;
+    pthread_mutex_t ownLock;
+};
+
+static PoolHeader* poolHeader = NULL;  // NULL unless the pool is mapped from a file or shm
+static size_t mappingSize = 0;
+static int poolFd = -1;
+
+// Guards the bitmaps and the side table. Points into the header while the pool
+// is mapped, so that every process attached to a shared pool uses the same lock.
+static pthread_mutex_t heapLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Lives in the header too while the pool is mapped.
+static PoolSummary heapSummary;
+
+static MemPool defaultPool = {.summary = &heapSummary, .lock = &heapLock};
+
+// Pages of the pool the scavenger has looked at. A page's state counts the
+// passes it has been seen completely free, up to PAGE_DECOMMITTED.
+#define PAGE_DECOMMITTED 255
+#define SCAVENGE_SLICE_PAGES 16
+
+static struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool running;
+    bool stop;
+    unsigned intervalMs;
+    unsigned cpuPercent;
+    size_t pageSize;
+    size_t firstPage;           // pool offset of the first whole page
+    size_t pages;               // whole pages in the pool
+    unsigned char* pageState;   // NULL when pages are not decommitted
+    MemScavengerStats stats;
+} scavenger = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER};
+
+static void* alloc_block(MemPool* pool, size_t size);
+static void free_block(MemPool* pool, void* block);
+
+_Thread_local MemSmallCache memSmallCache;
+size_t memPoolGeneration = 1;  // advanced by mem_deinit to invalidate every cache; 0 marks a detached cache
+
+// Flushes a thread's cache back to the pool when the thread exits.
+static pthread_once_t smallCacheKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t smallCacheKey;
 
 /// @brief sets a bit to 1
 /// @param array
@@ -27,95 +129,466 @@ bool get_bit(const unsigned char* array, size_t index) {
     return array[index / 8] & (1 << (index % 8));
 }
 
+/// @brief rounds a length up to a whole number of pages
+/// @param size
+/// @return
+static size_t page_round(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+/// @brief finds the side table slot of a directly mapped block
+/// @param block
+/// @return the slot, or NULL if the block was not directly mapped
+static HugeBlock* huge_find(const void* block) {
+    for (size_t i = 0; i < MEM_HUGE_SLOTS; i++) {
+        if (hugeBlocks[i].addr && hugeBlocks[i].addr == block) return &hugeBlocks[i];
+    }
+    return NULL;
+}
+
+/// @brief maps a dedicated region for a large request
+/// @param size
+/// @return the new block, or NULL if no slot or mapping is available
+static void* huge_alloc(size_t size) {
+    HugeBlock* slot = NULL;
+    for (size_t i = 0; i < MEM_HUGE_SLOTS && !slot; i++) {
+        if (!hugeBlocks[i].addr) slot = &hugeBlocks[i];
+    }
+    if (!slot) return NULL;
+
+    size_t length = page_round(size);
+    void* addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) return NULL;
+
+    slot->addr = addr;
+    slot->length = length;
+    return addr;
+}
+
+/// @brief unmaps a directly mapped block and releases its slot
+/// @param slot
+static void huge_free(HugeBlock* slot) {
+    munmap(slot->addr, slot->length);
+    slot->addr = NULL;
+    slot->length = 0;
+}
+
+/// @brief resizes a directly mapped block, moving it back into the pool when
+/// it shrinks below the threshold
+/// @param slot
+/// @param size
+/// @return the resized block, or NULL if it could not be resized
+static void* huge_resize(HugeBlock* slot, size_t size) {
+    if (hugeThreshold && size >= hugeThreshold && !poolHeader) {
+        size_t length = page_round(size);
+        void* addr = mremap(slot->addr, slot->length, length, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED) return NULL;
+
+        slot->addr = addr;
+        slot->length = length;
+        return addr;
+    }
+
+    void* resizedBlock = alloc_block(&defaultPool, size);
+    if (!resizedBlock) return NULL;
+
+    memcpy(resizedBlock, slot->addr, size);
+    huge_free(slot);
+    return resizedBlock;
+}
+
+/// @brief returns the mapped length of a file-backed pool and sets the
+/// offsets of its bitmaps and pool in the header
+/// @param header
+/// @param size
+/// @return
+static size_t layout_pool_file(PoolHeader* header, size_t size) {
+    size_t bitmapSize = (size + 7) / 8;
+    header->poolSize = size;
+    header->startOffset = sizeof(PoolHeader);
+    header->endOffset = header->startOffset + bitmapSize;
+    header->poolOffset = page_round(header->endOffset + bitmapSize);
+    return header->poolOffset + size;
+}
+
+/// @brief points the allocator state into a mapped pool file
+/// @param base
+static void attach_pool_file(unsigned char* base) {
+    poolHeader = (PoolHeader*)base;
+    defaultPool.size = poolHeader->poolSize;
+    defaultPool.start = base + poolHeader->startOffset;
+    defaultPool.end = base + poolHeader->endOffset;
+    defaultPool.memory = base + poolHeader->poolOffset;
+}
+
+/**
+ * Sets the size from which allocations get their own mapping instead of a
+ * range in the pool. A threshold of 0 disables direct mapping.
+ *
+ * @param threshold The smallest request size that is mapped directly.
+ */
+void mem_set_huge_threshold(size_t threshold) {
+    hugeThreshold = threshold;
+}
+
 /**
  * Initializes the memory manager with a given size.
  *
  * @param size The size of the memory pool to allocate.
  */
 void mem_init(size_t size) {
-    memoryPool = malloc(size);
-    memorySize = size;
-    start = calloc((size + 7) / 8, sizeof(char));
-    end = calloc((size + 7) / 8, sizeof(char));
+    defaultPool.memory = malloc(size);
+    defaultPool.size = size;
+    defaultPool.start = calloc((size + 7) / 8, sizeof(char));
+    defaultPool.end = calloc((size + 7) / 8, sizeof(char));
+    heapSummary = (PoolSummary){0, size, 0};
+}
+
+/// @brief locks a pool, recovering the lock if its owner died
+/// @param pool
+static void pool_lock(MemPool* pool) {
+    if (pthread_mutex_lock(pool->lock) == EOWNERDEAD) pthread_mutex_consistent(pool->lock);
+}
+
+/// @brief unlocks a pool
+/// @param pool
+static void pool_unlock(MemPool* pool) {
+    pthread_mutex_unlock(pool->lock);
+}
+
+/// @brief initializes a mutex that can live in memory shared between processes
+/// @param lock
+static void init_shared_lock(pthread_mutex_t* lock) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/// @brief reads the header of an existing pool, waiting for its creator to
+/// finish when wait is set
+/// @param fd
+/// @param header
+/// @param wait
+/// @return true if the header is complete and describes a pool
+static bool read_pool_header(int fd, PoolHeader* header, bool wait) {
+    struct stat st;
+    for (int attempt = 0;; attempt++) {
+        if (fstat(fd, &st) != 0) return false;
+        if ((size_t)st.st_size >= sizeof(PoolHeader)) {
+            PoolHeader* mapped = mmap(NULL, sizeof(PoolHeader), PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) return false;
+            bool ready = __atomic_load_n(&mapped->ready, __ATOMIC_ACQUIRE);
+            if (ready) memcpy(header, mapped, sizeof(PoolHeader));
+            munmap(mapped, sizeof(PoolHeader));
+            if (ready) break;
+        }
+        if (!wait || attempt == 1000) return false;
+        usleep(1000);
+    }
+
+    return header->magic == POOL_FILE_MAGIC && header->version == POOL_FILE_VERSION &&
+           (size_t)st.st_size >= header->poolOffset + header->poolSize;
+}
+
+/// @brief maps a pool from a file descriptor, creating it in the file first
+/// when create is set
+/// @param fd
+/// @param size
+/// @param create
+/// @param attach whether other processes may have the pool mapped already
+/// @return
+static bool map_pool(int fd, size_t size, bool create, bool attach) {
+    PoolHeader header = {0};
+    size_t length;
+    if (create) {
+        header.magic = POOL_FILE_MAGIC;
+        header.version = POOL_FILE_VERSION;
+        header.root = MEM_NULL_OFFSET;
+        length = layout_pool_file(&header, size);
+        if (ftruncate(fd, length) != 0) return false;
+    } else {
+        if (!read_pool_header(fd, &header, attach)) return false;
+        length = header.poolOffset + header.poolSize;
+    }
+
+    unsigned char* base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) return false;
+
+    PoolHeader* mapped = (PoolHeader*)base;
+    if (create) memcpy(mapped, &header, sizeof(header));
+    // A lock found in a file may have been held when its last user stopped.
+    if (create || !attach) {
+        init_shared_lock(&mapped->lock);
+        mapped->summary = (PoolSummary){0, header.poolSize, 0};
+    }
+    if (create) __atomic_store_n(&mapped->ready, 1, __ATOMIC_RELEASE);
+
+    attach_pool_file(base);
+    mappingSize = length;
+    poolFd = fd;
+    defaultPool.lock = &mapped->lock;
+    defaultPool.summary = &mapped->summary;
+    return true;
 }
 
 /**
- * Allocates a block of memory of the given size from the memory pool.
+ * Initializes the memory manager with a pool that lives in a file. If the file
+ * already holds a pool it is mapped as is, with all allocations intact, and
+ * size is ignored; otherwise a new pool of the given size is created in it.
+ * Blocks are never mapped directly while the pool is file-backed, so that
+ * everything allocated is persisted. A pool file must only be open in one
+ * process at a time.
  *
- * @param size The size of the memory block to allocate.
- * @return A pointer to the allocated memory block, or NULL if the allocation
- * fails.
+ * @param path The file holding the pool.
+ * @param size The size of the memory pool to create.
+ * @return true on success, false if the file cannot be created or mapped, or
+ * holds something other than a pool.
  */
-void* mem_alloc(size_t size) {
-    if (size > memorySize) return NULL;
-    if (size == 0) return memoryPool; // :(
+bool mem_init_file(const char* path, size_t size) {
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool create = fstat(fd, &st) == 0 && st.st_size == 0;
+    if (!map_pool(fd, size, create, false)) {
+        close(fd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initializes the memory manager with a pool in a POSIX shared memory object
+ * that several processes can use at once. The first process to call this for
+ * a name creates the pool with the given size; later callers attach to it and
+ * see every allocation made so far, wherever the pool lands in their address
+ * space. Pass pointers between processes with mem_offset and mem_pointer.
+ *
+ * @param name The name of the shared memory object, starting with '/'.
+ * @param size The size of the memory pool to create.
+ * @return true on success, false if the object cannot be created or attached.
+ */
+bool mem_init_shared(const char* name, size_t size) {
+    bool create = true;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        create = false;
+        fd = shm_open(name, O_RDWR, 0600);
+    }
+    if (fd < 0) return false;
+
+    if (!map_pool(fd, size, create, true)) {
+        close(fd);
+        if (create) shm_unlink(name);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Removes a shared pool's name. Processes that are attached keep using it
+ * until they call mem_deinit.
+ *
+ * @param name The name passed to mem_init_shared.
+ * @return true if the name was removed.
+ */
+bool mem_unlink_shared(const char* name) {
+    return shm_unlink(name) == 0;
+}
+
+/**
+ * Writes all modified pages of a file-backed pool back to the file.
+ *
+ * @return true on success, or if the pool is not file-backed.
+ */
+bool mem_sync() {
+    if (!poolHeader) return true;
+    return msync(poolHeader, mappingSize, MS_SYNC) == 0;
+}
+
+/**
+ * Makes the current state of a file-backed pool durable: the pool is synced,
+ * the checkpoint counter in the header is advanced, and the file is flushed to
+ * stable storage.
+ *
+ * @return true on success, or if the pool is not file-backed.
+ */
+bool mem_checkpoint() {
+    if (!poolHeader) return true;
+    if (!mem_sync()) return false;
+
+    poolHeader->checkpoints++;
+    if (msync(poolHeader, page_round(sizeof(PoolHeader)), MS_SYNC) != 0) return false;
+    return fsync(poolFd) == 0;
+}
+
+/**
+ * Converts a pointer into the pool to an offset that stays valid wherever the
+ * pool is mapped.
+ *
+ * @param block A pointer into the pool, or NULL.
+ * @return The offset of block, or MEM_NULL_OFFSET for NULL or pointers outside
+ * the pool.
+ */
+size_t mem_offset(const void* block) {
+    if (!block || (const unsigned char*)block < (unsigned char*)defaultPool.memory) return MEM_NULL_OFFSET;
+
+    size_t offset = (const unsigned char*)block - (unsigned char*)defaultPool.memory;
+    return offset < defaultPool.size ? offset : MEM_NULL_OFFSET;
+}
+
+/**
+ * Converts an offset obtained from mem_offset back to a pointer.
+ *
+ * @param offset An offset into the pool, or MEM_NULL_OFFSET.
+ * @return A pointer into the pool, or NULL.
+ */
+void* mem_pointer(size_t offset) {
+    return offset < defaultPool.size ? (unsigned char*)defaultPool.memory + offset : NULL;
+}
+
+/**
+ * Records the object from which the data in a file-backed or shared pool can
+ * be found again after it is reopened or attached.
+ *
+ * @param block A pointer into the pool, or NULL to clear the root.
+ */
+void mem_set_root(void* block) {
+    if (poolHeader) poolHeader->root = mem_offset(block);
+}
+
+/**
+ * Returns the root object recorded with mem_set_root.
+ *
+ * @return The root object, or NULL if none is set or the pool is neither
+ * file-backed nor shared.
+ */
+void* mem_get_root() {
+    return poolHeader ? mem_pointer(poolHeader->root) : NULL;
+}
+
+/// @brief finds the first free run of size bytes and updates the summary;
+/// the pool lock must be held and the caller marks the run
+/// @param pool
+/// @param size at least 1
+/// @return the index of the run, or the pool size if there is none
+static size_t find_run(MemPool* pool, size_t size) {
+    if (size > pool->size || size > pool->summary->largestFree) return pool->size;
     size_t nrOfEmptySegments = 0;
+    size_t firstGap = pool->size;
     bool isEmpty = true;
 
-    for (size_t i = 0; i < memorySize; i++) {
-        if (get_bit(start, i)) {
+    for (size_t i = pool->summary->firstFree; i < pool->size; i++) {
+        if (get_bit(pool->start, i)) {
             isEmpty = false;
         }
+        if (isEmpty && firstGap == pool->size) firstGap = i;
 
         nrOfEmptySegments = (isEmpty) ? nrOfEmptySegments + 1 : 0;
         if (nrOfEmptySegments >= size) {
-            set_bit(start, i - size + 1);
-            set_bit(end, i);
-            return memoryPool + i - size + 1;
+            size_t first = i - size + 1;
+            pool->summary->firstFree = (firstGap == first) ? i + 1 : firstGap;
+            pool->summary->allocs++;
+            return first;
         }
 
-        if (get_bit(end, i) == true) {
+        if (get_bit(pool->end, i) == true) {
             isEmpty = true;
         }
     }
 
-    return NULL;
+    pool->summary->firstFree = firstGap;
+    if (size - 1 < pool->summary->largestFree) pool->summary->largestFree = size - 1;
+    return pool->size;
 }
 
-/**
- * Frees a previously allocated block of memory.
- *
- * @param block A pointer to the memory block to free.
- */
-void mem_free(void* block) {
+/// @brief allocates a block; the pool lock must be held
+/// @param pool
+/// @param size
+/// @return
+static void* alloc_block(MemPool* pool, size_t size) {
+    if (pool == &defaultPool && hugeThreshold && size >= hugeThreshold && !poolHeader) return huge_alloc(size);
+    if (size == 0) return pool->memory; // :(
+    size_t first = find_run(pool, size);
+    if (first == pool->size) return NULL;
+    set_bit(pool->start, first);
+    set_bit(pool->end, first + size - 1);
+    return pool->memory + first;
+}
+
+/// @brief allocates count adjacent blocks of size bytes with one search; the
+/// pool lock must be held
+/// @param pool
+/// @param size at least 1
+/// @param count at least 1
+/// @return the first block, or NULL if there is no run long enough
+static void* alloc_batch(MemPool* pool, size_t size, size_t count) {
+    if (count > pool->size / size) return NULL;
+    size_t first = find_run(pool, size * count);
+    if (first == pool->size) return NULL;
+    for (size_t i = 0; i < count; i++) {
+        set_bit(pool->start, first + i * size);
+        set_bit(pool->end, first + (i + 1) * size - 1);
+    }
+    return pool->memory + first;
+}
+
+/// @brief frees a block; the pool lock must be held
+/// @param pool
+/// @param block
+static void free_block(MemPool* pool, void* block) {
     if (!block) return;
 
-    size_t index = block - memoryPool;
-    if (index >= memorySize || get_bit(start, index) != 1) {
+    size_t index = block - pool->memory;
+    if (index >= pool->size) {
+        HugeBlock* slot = (pool == &defaultPool) ? huge_find(block) : NULL;
+        if (slot) huge_free(slot);
+        return;
+    }
+    if (get_bit(pool->start, index) != 1) {
         return;
     }
 
-    clear_bit(start, index);
-    while (get_bit(end, index) == 0) index++;
-    clear_bit(end, index);
+    if (index < pool->summary->firstFree) pool->summary->firstFree = index;
+    pool->summary->largestFree = pool->size;
+    pool->summary->frees++;
+
+    clear_bit(pool->start, index);
+    while (get_bit(pool->end, index) == 0) index++;
+    clear_bit(pool->end, index);
 }
 
-/**
- * Resizes a previously allocated block of memory.
- *
- * @param block A pointer to the memory block to resize.
- * @param size The new size of the memory block.
- * @return A pointer to the resized memory block, or NULL if the allocation
- * fails.
- */
-void* mem_resize(void* block, size_t size) {
+/// @brief resizes a block; the pool lock must be held
+/// @param pool
+/// @param block
+/// @param size
+/// @return
+static void* resize_block(MemPool* pool, void* block, size_t size) {
     if (size == 0) {
-        mem_free(block);
+        free_block(pool, block);
         return NULL;
     }
-    if (!block) return mem_alloc(size);
+    if (!block) return alloc_block(pool, size);
 
-    size_t startIndex = block - memoryPool;
-    if (startIndex >= memorySize || !get_bit(start, startIndex)) return NULL;
+    size_t startIndex = block - pool->memory;
+    if (startIndex >= pool->size) {
+        HugeBlock* slot = (pool == &defaultPool) ? huge_find(block) : NULL;
+        return slot ? huge_resize(slot, size) : NULL;
+    }
+    if (!get_bit(pool->start, startIndex)) return NULL;
 
     size_t endIndex = startIndex;
-    while (!get_bit(end, endIndex)) endIndex++;
-    mem_free(block);
-    void* resizedBlock = mem_alloc(size);
+    while (!get_bit(pool->end, endIndex)) endIndex++;
+    free_block(pool, block);
+    void* resizedBlock = alloc_block(pool, size);
 
     if (!resizedBlock) {
-        set_bit(start, startIndex);
-        set_bit(end, endIndex);
+        set_bit(pool->start, startIndex);
+        set_bit(pool->end, endIndex);
         return NULL;
     }
 
@@ -131,13 +604,600 @@ void* mem_resize(void* block, size_t size) {
     }
 }
 
+/**
+ * Creates a pool that is independent of the default one and of every other
+ * pool: it has its own lock and bitmaps, and all of it, blocks included, is
+ * released at once by mem_pool_destroy. Requests are always served from the
+ * pool itself, never from a mapping of their own.
+ *
+ * @param size The size of the memory pool to allocate.
+ * @return The new pool, or NULL if it cannot be allocated.
+ */
+MemPool* mem_pool_create(size_t size) {
+    size_t bitmapSize = (size + 7) / 8;
+    // Keeps the blocks as aligned as malloc's
+    size_t offset = (sizeof(MemPool) + 2 * bitmapSize + 15) / 16 * 16;
+    if (size > SIZE_MAX - offset) return NULL;
+
+    MemPool* pool = malloc(offset + size);
+    if (!pool) return NULL;
+    pool->start = (unsigned char*)(pool + 1);
+    pool->end = pool->start + bitmapSize;
+    memset(pool->start, 0, 2 * bitmapSize);
+    pool->memory = (unsigned char*)pool + offset;
+    pool->size = size;
+    pool->ownSummary = (PoolSummary){0, size, 0};
+    pool->summary = &pool->ownSummary;
+    pthread_mutex_init(&pool->ownLock, NULL);
+    pool->lock = &pool->ownLock;
+    return pool;
+}
+
+/**
+ * Releases a pool made by mem_pool_create together with every block still
+ * allocated from it, in constant time.
+ *
+ * @param pool The pool, or NULL. The default pool is left alone; it is
+ * released by mem_deinit.
+ */
+void mem_pool_destroy(MemPool* pool) {
+    if (!pool || pool == &defaultPool) return;
+    pthread_mutex_destroy(&pool->ownLock);
+    free(pool);
+}
+
+/// @brief resolves the pool argument of the mem_pool_* functions
+/// @param pool
+/// @return
+static MemPool* pool_or_default(MemPool* pool) {
+    return pool ? pool : &defaultPool;
+}
+
+/**
+ * Allocates a block of memory of the given size from a pool.
+ *
+ * @param pool The pool, or NULL for the default pool.
+ * @param size The size of the memory block to allocate.
+ * @return A pointer to the allocated memory block, or NULL if the allocation
+ * fails.
+ */
+void* mem_pool_alloc(MemPool* pool, size_t size) {
+    pool = pool_or_default(pool);
+    pool_lock(pool);
+    void* block = alloc_block(pool, size);
+    pool_unlock(pool);
+    return block;
+}
+
+/**
+ * Allocates count adjacent blocks of the given size from a pool, like
+ * mem_alloc_batch.
+ *
+ * @param pool The pool, or NULL for the default pool.
+ * @param size The size of each block.
+ * @param count The number of blocks.
+ * @return A pointer to the first block, or NULL if size or count is 0 or the
+ * pool has no free run of size * count bytes.
+ */
+void* mem_pool_alloc_batch(MemPool* pool, size_t size, size_t count) {
+    if (size == 0 || count == 0) return NULL;
+    pool = pool_or_default(pool);
+    pool_lock(pool);
+    void* block = alloc_batch(pool, size, count);
+    pool_unlock(pool);
+    return block;
+}
+
+/**
+ * Frees a block previously allocated from a pool.
+ *
+ * @param pool The pool the block came from, or NULL for the default pool.
+ * @param block A pointer to the memory block to free.
+ */
+void mem_pool_free(MemPool* pool, void* block) {
+    pool = pool_or_default(pool);
+    pool_lock(pool);
+    free_block(pool, block);
+    pool_unlock(pool);
+}
+
+/**
+ * Frees several blocks of a pool under a single acquisition of its lock.
+ *
+ * @param pool The pool the blocks came from, or NULL for the default pool.
+ * @param blocks The blocks to free. NULL entries are skipped.
+ * @param count The number of entries in blocks.
+ */
+void mem_pool_free_batch(MemPool* pool, void** blocks, size_t count) {
+    pool = pool_or_default(pool);
+    pool_lock(pool);
+    for (size_t i = 0; i < count; i++) free_block(pool, blocks[i]);
+    pool_unlock(pool);
+}
+
+/**
+ * Resizes a block previously allocated from a pool, within that pool.
+ *
+ * @param pool The pool the block came from, or NULL for the default pool.
+ * @param block A pointer to the memory block to resize.
+ * @param size The new size of the memory block.
+ * @return A pointer to the resized memory block, or NULL if the allocation
+ * fails.
+ */
+void* mem_pool_resize(MemPool* pool, void* block, size_t size) {
+    pool = pool_or_default(pool);
+    pool_lock(pool);
+    void* resizedBlock = resize_block(pool, block, size);
+    pool_unlock(pool);
+    return resizedBlock;
+}
+
+/**
+ * Allocates a block of memory of the given size from the memory pool.
+ *
+ * @param size The size of the memory block to allocate.
+ * @return A pointer to the allocated memory block, or NULL if the allocation
+ * fails.
+ */
+void* mem_alloc(size_t size) {
+    return mem_pool_alloc(&defaultPool, size);
+}
+
+/**
+ * Allocates count blocks of the given size that lie next to each other in
+ * the pool, with a single search. Block i starts at size * i bytes after the
+ * returned pointer, and each block is freed on its own with mem_free.
+ *
+ * @param size The size of each block.
+ * @param count The number of blocks.
+ * @return A pointer to the first block, or NULL if size or count is 0 or the
+ * pool has no free run of size * count bytes. Never a huge mapping.
+ */
+void* mem_alloc_batch(size_t size, size_t count) {
+    return mem_pool_alloc_batch(&defaultPool, size, count);
+}
+
+/**
+ * Frees a previously allocated block of memory.
+ *
+ * @param block A pointer to the memory block to free.
+ */
+void mem_free(void* block) {
+    mem_pool_free(&defaultPool, block);
+}
+
+/**
+ * Frees several blocks under a single acquisition of the pool lock.
+ *
+ * @param blocks The blocks to free. NULL entries are skipped.
+ * @param count The number of entries in blocks.
+ */
+void mem_free_batch(void** blocks, size_t count) {
+    mem_pool_free_batch(&defaultPool, blocks, count);
+}
+
+/**
+ * Resizes a previously allocated block of memory.
+ *
+ * @param block A pointer to the memory block to resize.
+ * @param size The new size of the memory block.
+ * @return A pointer to the resized memory block, or NULL if the allocation
+ * fails.
+ */
+void* mem_resize(void* block, size_t size) {
+    return mem_pool_resize(&defaultPool, block, size);
+}
+
+/// @brief tells whether the byte before index lies inside a block that is
+/// still open at index; the pool lock must be held
+/// @param index
+/// @return
+static bool block_open_before(size_t index) {
+    while (index > 0) {
+        index--;
+        if (index % 8 == 7 && !defaultPool.start[index / 8] && !defaultPool.end[index / 8]) {
+            index -= 7;
+            continue;
+        }
+        if (get_bit(defaultPool.end, index)) return false;
+        if (get_bit(defaultPool.start, index)) return true;
+    }
+    return false;
+}
+
+/// @brief moves the first free hint past blocks that are allocated; the pool
+/// lock must be held
+/// @param budget the number of blocks to skip at most
+static void advance_first_free(size_t budget) {
+    size_t i = defaultPool.summary->firstFree;
+    while (budget-- && i < defaultPool.size && get_bit(defaultPool.start, i)) {
+        while (!get_bit(defaultPool.end, i)) i++;
+        i++;
+    }
+    defaultPool.summary->firstFree = i;
+}
+
+// Where a scavenger pass is, carried from one slice to the next.
+typedef struct ScavengeCursor {
+    size_t from;     // first byte of the next slice
+    size_t run;      // length of the free run that ends at from
+    size_t largest;  // longest free run seen in this pass
+    bool inBlock;    // whether the byte before from is inside a block
+    size_t allocs;   // allocations of the pool when the last slice ended
+} ScavengeCursor;
+
+/// @brief scans pool bytes [cursor->from, to), extending the current free run
+/// and decommitting whole pages that have been free for long enough; the pool
+/// lock must be held
+/// @param cursor advanced to to
+/// @param to
+static void scavenge_slice(ScavengeCursor* cursor, size_t to) {
+    size_t from = cursor->from;
+    size_t* run = &cursor->run;
+    size_t* largest = &cursor->largest;
+    bool used[SCAVENGE_SLICE_PAGES] = {false};
+    size_t firstPageInSlice = (from > scavenger.firstPage) ? (from - scavenger.firstPage) / scavenger.pageSize : 0;
+    // The state carried from the last slice only goes stale if a block was
+    // allocated across from since then; a stale "in a block" only keeps pages
+    // committed for one more pass, so blocks are never walked back over
+    if (!cursor->inBlock && cursor->allocs != defaultPool.summary->allocs) cursor->inBlock = block_open_before(from);
+    bool inBlock = cursor->inBlock;
+
+    for (size_t i = from; i < to;) {
+        // Eight bytes without a block boundary share the current state
+        size_t span = 1;
+        if (i % 8 == 0 && i + 8 <= to && !defaultPool.start[i / 8] && !defaultPool.end[i / 8]) {
+            span = 8;
+        } else if (get_bit(defaultPool.start, i)) {
+            inBlock = true;
+        }
+
+        if (!inBlock) {
+            *run += span;
+        } else {
+            if (*run > *largest) *largest = *run;
+            *run = 0;
+            for (size_t k = i; k < i + span; k++) {
+                if (k < scavenger.firstPage) continue;
+                size_t page = (k - scavenger.firstPage) / scavenger.pageSize - firstPageInSlice;
+                if (page < SCAVENGE_SLICE_PAGES) used[page] = true;
+            }
+        }
+
+        if (span == 1 && get_bit(defaultPool.end, i)) inBlock = false;
+        i += span;
+    }
+    if (*run > *largest) *largest = *run;
+    cursor->from = to;
+    cursor->inBlock = inBlock;
+    cursor->allocs = defaultPool.summary->allocs;
+
+    if (!scavenger.pageState || to <= scavenger.firstPage) return;
+    for (size_t k = 0; k < SCAVENGE_SLICE_PAGES; k++) {
+        size_t page = firstPageInSlice + k;
+        size_t pageStart = scavenger.firstPage + page * scavenger.pageSize;
+        if (page >= scavenger.pages || pageStart + scavenger.pageSize > to) break;
+
+        unsigned char* state = &scavenger.pageState[page];
+        if (used[k]) {
+            *state = 0;
+        } else if (*state < MEM_SCAVENGE_IDLE_PASSES) {
+            (*state)++;
+        } else if (*state != PAGE_DECOMMITTED) {
+            madvise((unsigned char*)defaultPool.memory + pageStart, scavenger.pageSize, MADV_DONTNEED);
+            *state = PAGE_DECOMMITTED;
+            scavenger.stats.decommittedPages++;
+        }
+    }
+}
+
+/// @brief sleeps long enough after a slice to keep the scavenger within its
+/// CPU budget
+/// @param sliceStart
+static void scavenge_throttle(const struct timespec* sliceStart) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long busy = (now.tv_sec - sliceStart->tv_sec) * 1000000000LL + (now.tv_nsec - sliceStart->tv_nsec);
+    long long idle = busy * (100 - scavenger.cpuPercent) / scavenger.cpuPercent;
+    if (idle <= 0) return;
+
+    struct timespec pause = {idle / 1000000000LL, idle % 1000000000LL};
+    nanosleep(&pause, NULL);
+}
+
+/// @brief runs one pass of the scavenger over the whole pool
+static void scavenge_pass() {
+    pool_lock(&defaultPool);
+    advance_first_free(1024);
+    size_t frees = defaultPool.summary->frees;
+    ScavengeCursor cursor = {.allocs = defaultPool.summary->allocs};
+    pool_unlock(&defaultPool);
+
+    // Slices end on page boundaries so every page is judged under one lock hold
+    size_t sliceBytes = SCAVENGE_SLICE_PAGES * scavenger.pageSize;
+    while (cursor.from < defaultPool.size && !__atomic_load_n(&scavenger.stop, __ATOMIC_RELAXED)) {
+        size_t to = (cursor.from < scavenger.firstPage) ? scavenger.firstPage : cursor.from + sliceBytes;
+        if (to > defaultPool.size) to = defaultPool.size;
+
+        struct timespec sliceStart;
+        clock_gettime(CLOCK_MONOTONIC, &sliceStart);
+        pool_lock(&defaultPool);
+        scavenge_slice(&cursor, to);
+        pool_unlock(&defaultPool);
+        scavenge_throttle(&sliceStart);
+    }
+    if (cursor.from < defaultPool.size) return;
+
+    // A free during the pass may have made a longer run than the scan saw
+    pool_lock(&defaultPool);
+    if (defaultPool.summary->frees == frees && cursor.largest < defaultPool.summary->largestFree) defaultPool.summary->largestFree = cursor.largest;
+    pool_unlock(&defaultPool);
+
+    pthread_mutex_lock(&scavenger.lock);
+    scavenger.stats.passes++;
+    pthread_mutex_unlock(&scavenger.lock);
+}
+
+/// @brief body of the scavenger thread
+/// @param arg
+/// @return
+static void* scavenger_main(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&scavenger.lock);
+    while (!scavenger.stop) {
+        pthread_mutex_unlock(&scavenger.lock);
+        scavenge_pass();
+        pthread_mutex_lock(&scavenger.lock);
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += scavenger.intervalMs / 1000;
+        deadline.tv_nsec += (long)(scavenger.intervalMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (!scavenger.stop && pthread_cond_timedwait(&scavenger.wake, &scavenger.lock, &deadline) == 0) {
+        }
+    }
+    pthread_mutex_unlock(&scavenger.lock);
+    return NULL;
+}
+
+/**
+ * Starts a background thread that maintains the pool: it tightens the hints
+ * mem_alloc uses to skip allocated space and to fail fast, and returns pages
+ * that have stayed free for MEM_SCAVENGE_IDLE_PASSES passes to the OS. Free
+ * ranges need no merging, since the bitmaps never split them. Pages of file
+ * or shared pools are left alone. The thread is stopped by mem_deinit.
+ *
+ * @param intervalMs The time to sleep between two passes over the pool.
+ * @param cpuPercent The share of one CPU a pass may use, from 1 to 100.
+ * @return true if the thread was started, false if it is already running or
+ * could not be created.
+ */
+bool mem_scavenger_start(unsigned intervalMs, unsigned cpuPercent) {
+    if (scavenger.running || !defaultPool.memory) return false;
+    if (cpuPercent < 1) cpuPercent = 1;
+    if (cpuPercent > 100) cpuPercent = 100;
+
+    scavenger.intervalMs = intervalMs;
+    scavenger.cpuPercent = cpuPercent;
+    scavenger.stop = false;
+    scavenger.stats = (MemScavengerStats){0, 0};
+    scavenger.pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+    size_t misalignment = (uintptr_t)defaultPool.memory % scavenger.pageSize;
+    scavenger.firstPage = misalignment ? scavenger.pageSize - misalignment : 0;
+    scavenger.pages = (defaultPool.size > scavenger.firstPage) ? (defaultPool.size - scavenger.firstPage) / scavenger.pageSize : 0;
+    scavenger.pageState = NULL;
+    if (!poolHeader && scavenger.pages) {
+        scavenger.pageState = calloc(scavenger.pages, sizeof(unsigned char));
+        if (!scavenger.pageState) return false;
+    }
+
+    if (pthread_create(&scavenger.thread, NULL, scavenger_main, NULL) != 0) {
+        free(scavenger.pageState);
+        scavenger.pageState = NULL;
+        return false;
+    }
+    scavenger.running = true;
+    return true;
+}
+
+/**
+ * Stops the scavenger thread and waits for it to finish its current slice.
+ * Does nothing if it is not running.
+ */
+void mem_scavenger_stop() {
+    if (!scavenger.running) return;
+
+    pthread_mutex_lock(&scavenger.lock);
+    __atomic_store_n(&scavenger.stop, true, __ATOMIC_RELAXED);
+    pthread_cond_signal(&scavenger.wake);
+    pthread_mutex_unlock(&scavenger.lock);
+    pthread_join(scavenger.thread, NULL);
+
+    free(scavenger.pageState);
+    scavenger.pageState = NULL;
+    scavenger.running = false;
+}
+
+/**
+ * Reports what the scavenger has done since it was started.
+ *
+ * @param stats Receives the statistics.
+ */
+void mem_scavenger_stats(MemScavengerStats* stats) {
+    pthread_mutex_lock(&scavenger.lock);
+    *stats = scavenger.stats;
+    pthread_mutex_unlock(&scavenger.lock);
+}
+
+/// @brief returns every block in the calling thread's cache to the pool and
+/// empties the cache; a cache that was not attached stays detached
+static void small_cache_drain() {
+    bool attached = memSmallCache.generation == memPoolGeneration;
+    if (attached) {
+        pool_lock(&defaultPool);
+        for (size_t sizeClass = 0; sizeClass < MEM_SMALL_CLASSES; sizeClass++) {
+            void* block = memSmallCache.free[sizeClass];
+            while (block) {
+                void* next;
+                memcpy(&next, block, sizeof(void*));
+                free_block(&defaultPool, block);
+                block = next;
+            }
+        }
+        pool_unlock(&defaultPool);
+    }
+    memset(&memSmallCache, 0, sizeof(memSmallCache));
+    if (attached) memSmallCache.generation = memPoolGeneration;
+}
+
+/// @brief thread exit hook that drains the exiting thread's cache
+/// @param arg
+static void small_cache_exit(void* arg) {
+    (void)arg;
+    small_cache_drain();
+}
+
+/// @brief creates the key whose destructor drains caches at thread exit
+static void small_cache_key_create() {
+    pthread_key_create(&smallCacheKey, small_cache_exit);
+}
+
+/// @brief makes the calling thread's cache usable for the current pool and
+/// registers it to be drained when the thread exits; the fast paths only use
+/// attached caches, so no block is left behind in a thread that never
+/// allocated
+static void small_cache_attach() {
+    if (memSmallCache.generation != memPoolGeneration) {
+        // The cached blocks belonged to a pool that is gone
+        memset(&memSmallCache, 0, sizeof(memSmallCache));
+        memSmallCache.generation = memPoolGeneration;
+    }
+    pthread_once(&smallCacheKeyOnce, small_cache_key_create);
+    pthread_setspecific(smallCacheKey, &memSmallCache);
+}
+
+/**
+ * Slow path of mem_alloc_small: refills the calling thread's cache for the
+ * size class with MEM_SMALL_REFILL blocks taken from the pool under a single
+ * lock, or allocates directly if the request is not small.
+ *
+ * @param size The size of the memory block to allocate.
+ * @return A pointer to the allocated memory block, or NULL if the allocation
+ * fails.
+ */
+void* mem_alloc_small_slow(size_t size) {
+    size_t sizeClass = (size - 1) / MEM_SMALL_GRANULE;
+    if (!size || sizeClass >= MEM_SMALL_CLASSES) return mem_alloc(size);
+    small_cache_attach();
+
+    size_t classSize = (sizeClass + 1) * MEM_SMALL_GRANULE;
+    pool_lock(&defaultPool);
+    char* batch = alloc_batch(&defaultPool, classSize, MEM_SMALL_REFILL);
+    if (batch) {
+        // Push the spares so that the cache hands them out in address order
+        for (int i = MEM_SMALL_REFILL - 1; i >= 1; i--) {
+            void* spare = batch + i * classSize;
+            memcpy(spare, &memSmallCache.free[sizeClass], sizeof(void*));
+            memSmallCache.free[sizeClass] = spare;
+            memSmallCache.count[sizeClass]++;
+        }
+        pool_unlock(&defaultPool);
+        return batch;
+    }
+    // No run for a whole refill: take what single blocks there are
+    void* block = alloc_block(&defaultPool, classSize);
+    for (int i = 1; block && i < MEM_SMALL_REFILL; i++) {
+        void* spare = alloc_block(&defaultPool, classSize);
+        if (!spare) break;
+        memcpy(spare, &memSmallCache.free[sizeClass], sizeof(void*));
+        memSmallCache.free[sizeClass] = spare;
+        memSmallCache.count[sizeClass]++;
+    }
+    pool_unlock(&defaultPool);
+    return block;
+}
+
+/**
+ * Slow path of mem_free_small: hands half of a full size class back to the
+ * pool under a single lock and frees the block, or frees directly if the
+ * block is not small.
+ *
+ * @param block A pointer to the memory block to free.
+ * @param size The size that was passed to mem_alloc_small.
+ */
+void mem_free_small_slow(void* block, size_t size) {
+    size_t sizeClass = (size - 1) / MEM_SMALL_GRANULE;
+    if (!block || !size || sizeClass >= MEM_SMALL_CLASSES) {
+        mem_free(block);
+        return;
+    }
+    if (memSmallCache.generation != memPoolGeneration) {
+        // First small free of a thread that has not allocated from this pool
+        small_cache_attach();
+        mem_free_small(block, size);
+        return;
+    }
+
+    pool_lock(&defaultPool);
+    free_block(&defaultPool, block);
+    while (memSmallCache.count[sizeClass] > MEM_SMALL_CACHE_MAX / 2) {
+        void* spare = memSmallCache.free[sizeClass];
+        memcpy(&memSmallCache.free[sizeClass], spare, sizeof(void*));
+        memSmallCache.count[sizeClass]--;
+        free_block(&defaultPool, spare);
+    }
+    pool_unlock(&defaultPool);
+}
+
+/**
+ * Returns every block cached by the calling thread to the pool. Caches are
+ * also flushed when their thread exits.
+ */
+void mem_small_flush() {
+    small_cache_drain();
+}
+
 /**
  * Deinitializes the memory manager by freeing all allocated memory blocks and
  * resetting the memory manager state.
  */
 void mem_deinit() {
-    free(start);
-    free(end);
-    free(memoryPool);
-    memorySize = 0;
+    mem_scavenger_stop();
+    memPoolGeneration++;
+    for (size_t i = 0; i < MEM_HUGE_SLOTS; i++) {
+        if (hugeBlocks[i].addr) huge_free(&hugeBlocks[i]);
+    }
+    if (poolHeader) {
+        msync(poolHeader, mappingSize, MS_SYNC);
+        munmap(poolHeader, mappingSize);
+        close(poolFd);
+        poolHeader = NULL;
+        mappingSize = 0;
+        poolFd = -1;
+        defaultPool.lock = &heapLock;
+        defaultPool.summary = &heapSummary;
+    } else {
+        free(defaultPool.start);
+        free(defaultPool.end);
+        free(defaultPool.memory);
+    }
+    defaultPool.memory = NULL;
+    defaultPool.start = NULL;
+    defaultPool.end = NULL;
+    defaultPool.size = 0;
+}
+
+/**
+ * Tells whether the default pool is set up, by mem_init, mem_init_file or
+ * mem_init_shared, and not released by mem_deinit since.
+ *
+ * @return true if the default pool is initialized.
+ */
+bool mem_initialized() {
+    return defaultPool.memory != NULL;
 }
\ No newline at end of file
@@ -6,10 +6,137 @@
 #include <string.h>
 #include <stdbool.h>
 
+// Requests of at least this many bytes bypass the pool and get their own
+// mapping. Can be changed at runtime with mem_set_huge_threshold().
+#ifndef MEM_HUGE_THRESHOLD
+#define MEM_HUGE_THRESHOLD (2 * 1024 * 1024)
+#endif
+
+// Number of directly mapped blocks that can be live at the same time.
+#ifndef MEM_HUGE_SLOTS
+#define MEM_HUGE_SLOTS 64
+#endif
+
+// Number of passes a page of the pool must stay free before the scavenger
+// returns it to the OS.
+#ifndef MEM_SCAVENGE_IDLE_PASSES
+#define MEM_SCAVENGE_IDLE_PASSES 2
+#endif
+
+typedef struct MemScavengerStats {
+    size_t passes;            // complete passes over the pool
+    size_t decommittedPages;  // pages handed back to the OS
+} MemScavengerStats;
+
+// Requests of up to MEM_SMALL_CLASSES * MEM_SMALL_GRANULE bytes can go through
+// mem_alloc_small, which serves them from a per-thread cache of free blocks.
+#ifndef MEM_SMALL_GRANULE
+#define MEM_SMALL_GRANULE 16
+#endif
+#ifndef MEM_SMALL_CLASSES
+#define MEM_SMALL_CLASSES 8
+#endif
+
+// Blocks fetched from the pool at once when a size class runs dry, and blocks
+// a size class may hold before mem_free_small hands some back.
+#ifndef MEM_SMALL_REFILL
+#define MEM_SMALL_REFILL 32
+#endif
+#ifndef MEM_SMALL_CACHE_MAX
+#define MEM_SMALL_CACHE_MAX 256
+#endif
+
+typedef struct MemSmallCache {
+    void* free[MEM_SMALL_CLASSES];     // free blocks, linked through their first bytes
+    size_t count[MEM_SMALL_CLASSES];   // length of each list
+    size_t generation;                 // pool generation the lists belong to
+} MemSmallCache;
+
+extern _Thread_local MemSmallCache memSmallCache;
+extern size_t memPoolGeneration;
+
+// An independent pool made by mem_pool_create. The mem_pool_* functions take
+// NULL for the default pool, the one set up by mem_init and used by mem_alloc.
+typedef struct MemPool MemPool;
+
+// Offset returned by mem_offset for pointers that are not in the pool.
+#define MEM_NULL_OFFSET ((size_t)-1)
+
 void mem_init(size_t size);
+bool mem_init_file(const char* path, size_t size);
+bool mem_init_shared(const char* name, size_t size);
+bool mem_unlink_shared(const char* name);
 void* mem_alloc(size_t size);
+void* mem_alloc_batch(size_t size, size_t count);
 void mem_free(void* block);
+void mem_free_batch(void** blocks, size_t count);
 void* mem_resize(void* block, size_t size);
 void mem_deinit();
+bool mem_initialized();
+
+MemPool* mem_pool_create(size_t size);
+void mem_pool_destroy(MemPool* pool);
+void* mem_pool_alloc(MemPool* pool, size_t size);
+void* mem_pool_alloc_batch(MemPool* pool, size_t size, size_t count);
+void mem_pool_free(MemPool* pool, void* block);
+void mem_pool_free_batch(MemPool* pool, void** blocks, size_t count);
+void* mem_pool_resize(MemPool* pool, void* block, size_t size);
+
+void mem_set_huge_threshold(size_t threshold);
+
+bool mem_sync();
+bool mem_checkpoint();
+size_t mem_offset(const void* block);
+void* mem_pointer(size_t offset);
+void mem_set_root(void* block);
+void* mem_get_root();
+
+bool mem_scavenger_start(unsigned intervalMs, unsigned cpuPercent);
+void mem_scavenger_stop();
+void mem_scavenger_stats(MemScavengerStats* stats);
+
+void* mem_alloc_small_slow(size_t size);
+void mem_free_small_slow(void* block, size_t size);
+void mem_small_flush();
+
+/**
+ * Allocates a small block from the calling thread's cache, falling back to
+ * the pool when the cache is empty or the request is not small. The block is
+ * rounded up to its size class and can also be released with mem_free.
+ *
+ * @param size The size of the memory block to allocate.
+ * @return A pointer to the allocated memory block, or NULL if the allocation
+ * fails.
+ */
+static inline void* mem_alloc_small(size_t size) {
+    size_t sizeClass = (size - 1) / MEM_SMALL_GRANULE;
+    if (size && sizeClass < MEM_SMALL_CLASSES && memSmallCache.generation == memPoolGeneration) {
+        void* block = memSmallCache.free[sizeClass];
+        if (block) {
+            memcpy(&memSmallCache.free[sizeClass], block, sizeof(void*));
+            memSmallCache.count[sizeClass]--;
+            return block;
+        }
+    }
+    return mem_alloc_small_slow(size);
+}
+
+/**
+ * Returns a block obtained from mem_alloc_small to the calling thread's cache.
+ *
+ * @param block A pointer to the memory block to free.
+ * @param size The size that was passed to mem_alloc_small.
+ */
+static inline void mem_free_small(void* block, size_t size) {
+    size_t sizeClass = (size - 1) / MEM_SMALL_GRANULE;
+    if (block && size && sizeClass < MEM_SMALL_CLASSES && memSmallCache.generation == memPoolGeneration &&
+        memSmallCache.count[sizeClass] < MEM_SMALL_CACHE_MAX) {
+        memcpy(block, &memSmallCache.free[sizeClass], sizeof(void*));
+        memSmallCache.free[sizeClass] = block;
+        memSmallCache.count[sizeClass]++;
+        return;
+    }
+    mem_free_small_slow(block, size);
+}
 
-#endif
\ No newline at end of file
+#endif
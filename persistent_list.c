@@ -0,0 +1,251 @@
+#include "persistent_list.h"
+
+/// @brief allocates a node that holds one reference, for whoever links it
+/// @param data
+/// @param next the node to link to; the caller hands over one reference to it
+/// @return the new node, or NULL if the pool is full
+static PNode *pnode_new(uint16_t data, PNode *next) {
+    PNode *node = (PNode *)mem_alloc_small(sizeof(PNode));
+    if (node == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc_small()\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    node->data = data;
+    node->refs = 1;
+    node->next = next;
+    return node;
+}
+
+/// @brief takes a reference to a node
+/// @param node may be NULL
+static void pnode_retain(PNode *node) {
+    if (node != NULL) __atomic_add_fetch(&node->refs, 1, __ATOMIC_RELAXED);
+}
+
+/// @brief drops a reference to a node, freeing it and dropping its
+/// reference to the next node when it was the last one
+/// @param node may be NULL
+static void pnode_release(PNode *node) {
+    while (node != NULL && __atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        PNode *next = node->next;
+        mem_free_small(node, sizeof(PNode));
+        node = next;
+    }
+}
+
+/// @brief builds a version that is the current one with its first index
+/// nodes copied, followed by a new node with data if insert is set, and by
+/// the current version from node index + !insert on; the writer lock must be
+/// held
+/// @param list
+/// @param index
+/// @param data
+/// @param insert
+/// @return false if the pool is full; the current version is unchanged then
+static bool plist_rebuild(PList *list, size_t index, uint16_t data, bool insert) {
+    PNode *head = NULL;
+    PNode **link = &head;
+    PNode *current = list->current.head;
+    for (size_t i = 0; i < index; i++, current = current->next) {
+        PNode *copy = pnode_new(current->data, NULL);
+        if (copy == NULL) {
+            pnode_release(head);
+            return false;
+        }
+        *link = copy;
+        link = &copy->next;
+    }
+
+    PNode *rest = insert ? current : current->next;
+    pnode_retain(rest);
+    if (insert) {
+        PNode *node = pnode_new(data, rest);
+        if (node == NULL) {
+            pnode_release(rest);
+            pnode_release(head);
+            return false;
+        }
+        rest = node;
+    }
+    *link = rest;
+
+    PSnapshot old = list->current;
+    pthread_mutex_lock(&list->publishLock);
+    list->current.head = head;
+    list->current.count = insert ? old.count + 1 : old.count - 1;
+    pthread_mutex_unlock(&list->publishLock);
+    pnode_release(old.head);
+    return true;
+}
+
+/**
+ * Initializes the persistent list, and the default memory pool its nodes are
+ * taken from unless that is already initialized. An initialized pool is
+ * shared as it is, so other lists' nodes stay intact.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool, if it is initialized here. Nodes
+ * take 16 bytes, and each thread's small-allocation cache may hold up to
+ * MEM_SMALL_CACHE_MAX more.
+ */
+void plist_init(PList *list, size_t size) {
+    list->ownsPool = !mem_initialized();
+    if (list->ownsPool) mem_init(size);
+    list->current = (PSnapshot){NULL, 0};
+    pthread_mutex_init(&list->writeLock, NULL);
+    pthread_mutex_init(&list->publishLock, NULL);
+}
+
+/**
+ * Inserts a new node at the start of the list in constant time. The new
+ * version shares every node of the previous one.
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ * @return true on success, false if the pool is full.
+ */
+bool plist_prepend(PList *list, uint16_t data) {
+    return plist_insert_at(list, 0, data);
+}
+
+/**
+ * Inserts a new node at the end of the list. All nodes are copied, since
+ * the last one changes; prefer plist_prepend when the order allows it.
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ * @return true on success, false if the pool is full.
+ */
+bool plist_insert(PList *list, uint16_t data) {
+    pthread_mutex_lock(&list->writeLock);
+    bool inserted = plist_rebuild(list, list->current.count, data, true);
+    pthread_mutex_unlock(&list->writeLock);
+    return inserted;
+}
+
+/**
+ * Inserts a new node so that it becomes the node at index. The index nodes
+ * before it are copied and the rest are shared with the previous version.
+ *
+ * @param list The list.
+ * @param index The position of the new node, at most the number of nodes.
+ * @param data The data to be inserted.
+ * @return true on success, false if index is out of range or the pool is
+ * full.
+ */
+bool plist_insert_at(PList *list, size_t index, uint16_t data) {
+    pthread_mutex_lock(&list->writeLock);
+    bool inserted = index <= list->current.count && plist_rebuild(list, index, data, true);
+    pthread_mutex_unlock(&list->writeLock);
+    return inserted;
+}
+
+/**
+ * Deletes the first node with the given data. The nodes before it are copied
+ * and the rest are shared with the previous version.
+ *
+ * @param list The list.
+ * @param data The data of the node to be deleted.
+ * @return true if a node was deleted, false if there is none with the data
+ * or the pool is full.
+ */
+bool plist_delete(PList *list, uint16_t data) {
+    pthread_mutex_lock(&list->writeLock);
+    size_t index = 0;
+    PNode *current = list->current.head;
+    while (current != NULL && current->data != data) {
+        current = current->next;
+        index++;
+    }
+    bool deleted = current != NULL && plist_rebuild(list, index, data, false);
+    pthread_mutex_unlock(&list->writeLock);
+    return deleted;
+}
+
+/**
+ * Returns the number of nodes of the current version in constant time.
+ *
+ * @param list The list.
+ * @return The number of nodes.
+ */
+size_t plist_count(PList *list) {
+    pthread_mutex_lock(&list->publishLock);
+    size_t count = list->current.count;
+    pthread_mutex_unlock(&list->publishLock);
+    return count;
+}
+
+/**
+ * Takes a snapshot of the current version in constant time. It waits at
+ * most for a writer to publish a version, never for a whole update, and
+ * writers never wait for the readers of a snapshot.
+ *
+ * @param list The list.
+ * @return The snapshot, to be released with plist_release.
+ */
+PSnapshot plist_snapshot(PList *list) {
+    pthread_mutex_lock(&list->publishLock);
+    PSnapshot snapshot = list->current;
+    pnode_retain(snapshot.head);
+    pthread_mutex_unlock(&list->publishLock);
+    return snapshot;
+}
+
+/**
+ * Releases a snapshot. Nodes that no other version refers to go back to the
+ * pool, and the snapshot becomes empty.
+ *
+ * @param snapshot The snapshot.
+ */
+void plist_release(PSnapshot *snapshot) {
+    pnode_release(snapshot->head);
+    snapshot->head = NULL;
+    snapshot->count = 0;
+}
+
+/**
+ * Searches a snapshot for the first node with the given data. No lock is
+ * taken.
+ *
+ * @param snapshot The snapshot.
+ * @param data The data to search for.
+ * @return The node, or NULL if the snapshot holds no node with the data.
+ */
+const PNode *plist_search(const PSnapshot *snapshot, uint16_t data) {
+    const PNode *current = snapshot->head;
+    while (current != NULL && current->data != data) current = current->next;
+    return current;
+}
+
+/**
+ * Displays the values of a snapshot.
+ *
+ * @param snapshot The snapshot.
+ */
+void plist_display(const PSnapshot *snapshot) {
+    const PNode *current = snapshot->head;
+    if (current == NULL) {
+        printf("NULL");
+        return;
+    }
+
+    printf("[");
+    for (; current != NULL; current = current->next) {
+        printf(current == snapshot->head ? "%d" : ", %d", current->data);
+    }
+    printf("]");
+}
+
+/**
+ * Releases the current version, and the memory pool if plist_init
+ * initialized it. All snapshots must have been released, and no thread may
+ * use the list any more.
+ *
+ * @param list The list.
+ */
+void plist_cleanup(PList *list) {
+    plist_release(&list->current);
+    pthread_mutex_destroy(&list->writeLock);
+    pthread_mutex_destroy(&list->publishLock);
+    if (list->ownsPool) mem_deinit();
+}
@@ -0,0 +1,54 @@
+#ifndef PERSISTENT_LIST_H
+#define PERSISTENT_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "common_defs.h"
+#include "memory_manager.h"
+
+// A node of a persistent list. Nodes never change once they are linked, so
+// several versions of a list can share their common tail. refs counts the
+// versions and nodes that point to the node.
+typedef struct PNode {
+    uint16_t data;         // Stores the data as an unsigned 16-bit integer
+    uint32_t refs;         // references to this node, changed atomically
+    struct PNode* next;    // A pointer to the next node in the List
+} PNode;
+
+// An immutable version of a list. It stays valid, and unchanged, until it is
+// released with plist_release, whatever happens to the list it was taken from.
+typedef struct PSnapshot {
+    PNode* head;    // first node, NULL when the version is empty
+    size_t count;   // number of nodes
+} PSnapshot;
+
+// A list whose versions can be snapshotted in O(1). Writers build a new
+// version that shares the unchanged tail of the current one and publish it
+// in constant time; readers scan snapshots without taking any lock. Nodes are
+// taken from the default pool through the per-thread small-allocation cache,
+// and go back once no version refers to them. The cache only serves the
+// default pool, so a PList cannot take its nodes from a MemPool of its own;
+// lists share the default pool with everything else that allocates from it.
+typedef struct PList {
+    PSnapshot current;            // the version writers change
+    pthread_mutex_t writeLock;    // serializes writers for a whole update
+    pthread_mutex_t publishLock;  // guards current while it is swapped or snapshotted
+    bool ownsPool;                // plist_init initialized the default pool
+} PList;
+
+void plist_init(PList* list, size_t size);
+bool plist_prepend(PList* list, uint16_t data);
+bool plist_insert(PList* list, uint16_t data);
+bool plist_insert_at(PList* list, size_t index, uint16_t data);
+bool plist_delete(PList* list, uint16_t data);
+size_t plist_count(PList* list);
+PSnapshot plist_snapshot(PList* list);
+void plist_release(PSnapshot* snapshot);
+const PNode* plist_search(const PSnapshot* snapshot, uint16_t data);
+void plist_display(const PSnapshot* snapshot);
+void plist_cleanup(PList* list);
+
+#endif
@@ -0,0 +1,248 @@
+#include "skip_list.h"
+
+#include <time.h>
+
+/// @brief allocates a node with room for height levels
+/// @param height
+/// @param data
+/// @return the new node, or NULL if the pool is full
+static SNode *snode_new(uint8_t height, uint16_t data) {
+    SNode *node = (SNode *)mem_alloc(sizeof(SNode) + height * sizeof(SNode *));
+    if (node == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc()\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    node->data = data;
+    node->height = height;
+    for (uint8_t level = 0; level < height; level++) node->next[level] = NULL;
+    return node;
+}
+
+/// @brief draws a tower height, each level above the first with probability 1/4
+/// @param list
+/// @return a height between 1 and SLIST_MAX_LEVEL
+static uint8_t slist_random_height(SList *list) {
+    // xorshift32
+    uint32_t x = list->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    list->seed = x;
+
+    uint8_t height = 1;
+    while (height < SLIST_MAX_LEVEL && (x & 3) == 0) {
+        height++;
+        x >>= 2;
+    }
+    return height;
+}
+
+/// @brief finds, on every level, the last node whose value is below data
+/// (below or equal if inclusive)
+/// @param list
+/// @param data
+/// @param inclusive
+/// @param update receives the predecessor on each level, may be NULL
+/// @return the predecessor on level 0
+static SNode *slist_find_prev(SList *list, uint16_t data, bool inclusive, SNode **update) {
+    SNode *current = list->head;
+    for (int level = list->level - 1; level >= 0; level--) {
+        SNode *next = current->next[level];
+        while (next != NULL && (next->data < data || (inclusive && next->data == data))) {
+            current = next;
+            next = current->next[level];
+        }
+        if (update) update[level] = current;
+    }
+    return current;
+}
+
+/**
+ * Initializes the skip list and the memory pool its nodes are taken from.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool. Nodes take 16 bytes plus 8 per
+ * level above the first, about 19 bytes on average; the head takes 136.
+ */
+void slist_init(SList *list, size_t size) {
+    mem_init(size);
+    list->head = snode_new(SLIST_MAX_LEVEL, 0);
+    list->level = 1;
+    list->count = 0;
+    list->seed = (uint32_t)time(NULL) | 1;
+}
+
+/**
+ * Inserts a value in sorted order, after any equal values, in O(log n).
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ * @return The new node, or NULL if the pool is full.
+ */
+SNode *slist_insert(SList *list, uint16_t data) {
+    if (list->head == NULL) return NULL;
+    SNode *update[SLIST_MAX_LEVEL];
+    slist_find_prev(list, data, true, update);
+
+    uint8_t height = slist_random_height(list);
+    SNode *node = snode_new(height, data);
+    if (node == NULL) return NULL;
+    for (uint8_t level = list->level; level < height; level++) {
+        update[level] = list->head;
+    }
+    if (height > list->level) list->level = height;
+
+    for (uint8_t level = 0; level < height; level++) {
+        node->next[level] = update[level]->next[level];
+        update[level]->next[level] = node;
+    }
+    list->count++;
+    return node;
+}
+
+/**
+ * Deletes the first node with the given data from the list in O(log n).
+ *
+ * @param list The list.
+ * @param data The data of the node to be deleted.
+ */
+void slist_delete(SList *list, uint16_t data) {
+    if (list->head == NULL) return;
+    SNode *update[SLIST_MAX_LEVEL];
+    SNode *node = slist_find_prev(list, data, false, update)->next[0];
+    if (node == NULL || node->data != data) return;
+
+    for (uint8_t level = 0; level < node->height; level++) {
+        update[level]->next[level] = node->next[level];
+    }
+    while (list->level > 1 && list->head->next[list->level - 1] == NULL) {
+        list->level--;
+    }
+    list->count--;
+    mem_free(node);
+}
+
+/**
+ * Searches for the first node with the given data in O(log n).
+ *
+ * @param list The list.
+ * @param data The data to search for.
+ * @return A pointer to the node with the given data, or NULL if not found.
+ */
+SNode *slist_search(SList *list, uint16_t data) {
+    SNode *node = slist_lower_bound(list, data);
+    return (node != NULL && node->data == data) ? node : NULL;
+}
+
+/**
+ * Finds the first node whose value is not below data in O(log n).
+ *
+ * @param list The list.
+ * @param data The value to compare against.
+ * @return The node, or NULL if every value is below data.
+ */
+SNode *slist_lower_bound(SList *list, uint16_t data) {
+    if (list->head == NULL) return NULL;
+    return slist_find_prev(list, data, false, NULL)->next[0];
+}
+
+/**
+ * Finds the last node whose value is not above data in O(log n).
+ *
+ * @param list The list.
+ * @param data The value to compare against.
+ * @return The node, or NULL if every value is above data.
+ */
+SNode *slist_last_at_most(SList *list, uint16_t data) {
+    if (list->head == NULL) return NULL;
+    SNode *node = slist_find_prev(list, data, true, NULL);
+    return node == list->head ? NULL : node;
+}
+
+/**
+ * Displays the entire list.
+ *
+ * @param list The list.
+ */
+void slist_display(SList *list) {
+    if (list->count == 0) {
+        printf("NULL");
+        return;
+    }
+    slist_display_range(list, NULL, NULL);
+}
+
+/**
+ * Displays a selected range of the list, with the semantics of
+ * list_display_range.
+ *
+ * @param list The list.
+ * @param startNode A pointer to the starting node of the range, or NULL for
+ * the first node.
+ * @param endNode A pointer to the ending node of the range, or NULL for the
+ * last node.
+ */
+void slist_display_range(SList *list, SNode *startNode, SNode *endNode) {
+    if (list->count == 0) {
+        printf("[]");
+        return;
+    }
+
+    SNode *current = startNode ? startNode : list->head->next[0];
+    SNode *stop = endNode ? endNode->next[0] : NULL;
+    printf("[");
+    while (current != NULL && current != stop) {
+        printf("%d", current->data);
+        current = current->next[0];
+        if (current != stop) {
+            printf(", ");
+        }
+    }
+    printf("]");
+}
+
+/**
+ * Displays the values between low and high, inclusive. Both ends are found
+ * in O(log n) and the range is shown by slist_display_range.
+ *
+ * @param list The list.
+ * @param low The smallest value to show.
+ * @param high The largest value to show.
+ */
+void slist_display_values(SList *list, uint16_t low, uint16_t high) {
+    SNode *startNode = slist_lower_bound(list, low);
+    SNode *endNode = slist_last_at_most(list, high);
+    if (startNode == NULL || endNode == NULL || low > high || startNode->data > endNode->data) {
+        printf("[]");
+        return;
+    }
+    slist_display_range(list, startNode, endNode);
+}
+
+/**
+ * Returns the number of values in the list in constant time.
+ *
+ * @param list The list.
+ * @return The number of values.
+ */
+size_t slist_count(SList *list) {
+    return list->count;
+}
+
+/**
+ * Frees all nodes of the list and its memory pool.
+ *
+ * @param list The list.
+ */
+void slist_cleanup(SList *list) {
+    SNode *current = list->head;
+    while (current != NULL) {
+        SNode *next = current->next[0];
+        mem_free(current);
+        current = next;
+    }
+    list->head = NULL;
+    list->level = 1;
+    list->count = 0;
+    mem_deinit();
+}
@@ -0,0 +1,42 @@
+#ifndef SKIP_LIST_H
+#define SKIP_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "memory_manager.h"
+
+// Maximum tower height. With a promotion probability of 1/4 this keeps
+// searches logarithmic up to about 4^16 values.
+#define SLIST_MAX_LEVEL 16
+
+// A node of a skip list. It is allocated with room for exactly height next
+// pointers; next[0] links every node in sorted order.
+typedef struct SNode {
+    uint16_t data;          // Stores the data as an unsigned 16-bit integer
+    uint8_t height;         // Number of levels the node is linked into
+    struct SNode* next[];   // Next node on each level
+} SNode;
+
+// A sorted list. Equal values keep their insertion order.
+typedef struct SList {
+    SNode* head;     // sentinel with SLIST_MAX_LEVEL levels, holds no value
+    uint8_t level;   // number of levels in use
+    size_t count;    // number of values
+    uint32_t seed;   // state of the generator for tower heights
+} SList;
+
+void slist_init(SList* list, size_t size);
+SNode* slist_insert(SList* list, uint16_t data);
+void slist_delete(SList* list, uint16_t data);
+SNode* slist_search(SList* list, uint16_t data);
+SNode* slist_lower_bound(SList* list, uint16_t data);
+SNode* slist_last_at_most(SList* list, uint16_t data);
+void slist_display(SList* list);
+void slist_display_range(SList* list, SNode* startNode, SNode* endNode);
+void slist_display_values(SList* list, uint16_t low, uint16_t high);
+size_t slist_count(SList* list);
+void slist_cleanup(SList* list);
+
+#endif
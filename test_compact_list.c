@@ -0,0 +1,322 @@
+#include "compact_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Function to capture the output of clist_display_range.
+void capture_clist_display(char *buffer, size_t size, CList *list, CNode *start_node, CNode *end_node)
+{
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    stdout = fp;
+    clist_display_range(list, start_node, end_node);
+    fflush(fp);
+    rewind(fp);
+
+    size_t length = fread(buffer, 1, size - 1, fp);
+    buffer[length] = '\0';
+
+    fclose(fp);
+    stdout = original_stdout;
+}
+
+// ********* Test basic compact list operations *********
+
+void test_clist_node_size()
+{
+    printf_yellow(" Testing compact node size ---> ");
+    my_assert(sizeof(CNode) == 8);
+    my_assert(sizeof(CList) == 12);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_insert()
+{
+    printf_yellow(" Testing clist_insert ---> ");
+    CList list = {0, 0, 5};
+    my_assert(!clist_init(&list, CLIST_NIL)); // Too large for 32-bit links
+    my_assert(list.head == CLIST_NIL && list.tail == CLIST_NIL && list.count == 0);
+    my_assert(clist_init(&list, sizeof(CNode) * 2));
+    my_assert(list.head == CLIST_NIL && clist_count_nodes(&list) == 0);
+    clist_insert(&list, 10);
+    clist_insert(&list, 20);
+    CNode *head = clist_node(list.head);
+    my_assert(head->data == 10);
+    my_assert(clist_node(head->next)->data == 20);
+    my_assert(list.tail == head->next);
+    my_assert(clist_count_nodes(&list) == 2);
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_insert_after_before()
+{
+    printf_yellow(" Testing clist_insert_after and clist_insert_before ---> ");
+    CList list;
+    clist_init(&list, sizeof(CNode) * 5);
+    clist_insert(&list, 10);
+    clist_insert(&list, 30);
+
+    clist_insert_after(&list, clist_search(&list, 30), 40); // After the tail moves the tail
+    my_assert(clist_node(list.tail)->data == 40);
+    clist_insert_before(&list, clist_search(&list, 30), 20);
+    clist_insert_before(&list, clist_node(list.head), 5); // Before the head moves the head
+    my_assert(clist_node(list.head)->data == 5);
+
+    int expected[] = {5, 10, 20, 30, 40};
+    CNode *current = clist_node(list.head);
+    for (int i = 0; i < 5; i++)
+    {
+        my_assert(current->data == expected[i]);
+        current = clist_node(current->next);
+    }
+    my_assert(current == NULL);
+    my_assert(clist_count_nodes(&list) == 5);
+
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_delete()
+{
+    printf_yellow(" Testing clist_delete ---> ");
+    CList list;
+    clist_init(&list, sizeof(CNode) * 3);
+    clist_insert(&list, 10);
+    clist_insert(&list, 20);
+    clist_insert(&list, 30);
+    clist_delete(&list, 30); // Deleting the tail moves the tail back
+    my_assert(clist_node(list.tail)->data == 20);
+    clist_delete(&list, 10);
+    my_assert(clist_node(list.head)->data == 20);
+    clist_delete(&list, 20);
+    my_assert(list.head == CLIST_NIL && list.tail == CLIST_NIL);
+    my_assert(clist_count_nodes(&list) == 0);
+
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_search()
+{
+    printf_yellow(" Testing clist_search ---> ");
+    CList list;
+    clist_init(&list, sizeof(CNode) * 2);
+    clist_insert(&list, 10);
+    clist_insert(&list, 20);
+    CNode *found = clist_search(&list, 20);
+    my_assert(found != NULL && found->data == 20);
+    my_assert(clist_search(&list, 30) == NULL);
+
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_display()
+{
+    printf_yellow(" Testing clist_display ---> ");
+    CList list;
+    clist_init(&list, sizeof(CNode) * 4);
+    char buffer[256];
+
+    capture_clist_display(buffer, sizeof(buffer), &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[]") == 0);
+
+    clist_insert(&list, 11);
+    clist_insert(&list, 22);
+    clist_insert(&list, 33);
+    clist_insert(&list, 44);
+    capture_clist_display(buffer, sizeof(buffer), &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[11, 22, 33, 44]") == 0);
+    capture_clist_display(buffer, sizeof(buffer), &list, clist_search(&list, 22), clist_search(&list, 33));
+    my_assert(strcmp(buffer, "[22, 33]") == 0);
+    capture_clist_display(buffer, sizeof(buffer), &list, clist_search(&list, 33), NULL);
+    my_assert(strcmp(buffer, "[33, 44]") == 0);
+
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_relocation()
+{
+    printf_yellow(" Testing compact list reopened at another address ---> ");
+    char path[] = "/tmp/test_compact_list_XXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    close(fd);
+    unlink(path);
+
+    // The handle lives in the pool next to its nodes
+    my_assert(mem_init_file(path, 4096));
+    CList *list = mem_alloc(sizeof(CList));
+    my_assert(list != NULL);
+    *list = CLIST_EMPTY;
+    for (int i = 0; i < 100; i++)
+    {
+        clist_insert(list, i * 3);
+    }
+    mem_set_root(list);
+    unsigned char *oldBase = mem_pointer(0);
+    mem_deinit();
+
+    // Occupy the range that was just freed, so the pool usually lands elsewhere
+    size_t blockerSize = 2 * (size_t)sysconf(_SC_PAGESIZE); // Header page plus the pool
+    unsigned char *blocker = mmap(NULL, blockerSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    my_assert(blocker != MAP_FAILED);
+    my_assert(mem_init_file(path, 0));
+    if (oldBase >= blocker && oldBase < blocker + blockerSize)
+        my_assert(mem_pointer(0) != oldBase);
+
+    list = mem_get_root();
+    my_assert(list != NULL && clist_count_nodes(list) == 100);
+    int i = 0;
+    for (CNode *current = clist_node(list->head); current != NULL; current = clist_node(current->next))
+    {
+        my_assert(current->data == i * 3);
+        i++;
+    }
+    my_assert(i == 100);
+
+    mem_deinit();
+    munmap(blocker, blockerSize);
+    unlink(path);
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_clist_insert_loop(int count)
+{
+    printf_yellow(" Testing clist_insert loop ---> ");
+    CList list;
+    clist_init(&list, sizeof(CNode) * count);
+    for (int i = 0; i < count; i++)
+    {
+        clist_insert(&list, i);
+    }
+    my_assert(clist_count_nodes(&list) == count);
+
+    CNode *current = clist_node(list.head);
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(current->data == i);
+        current = clist_node(current->next);
+    }
+
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_clist_delete_loop(int count)
+{
+    printf_yellow(" Testing clist_delete loop ---> ");
+    CList list;
+    clist_init(&list, sizeof(CNode) * count);
+    for (int i = 0; i < count; i++)
+    {
+        clist_insert(&list, i);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        clist_delete(&list, i);
+    }
+    my_assert(list.head == CLIST_NIL);
+
+    clist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+  srand(time(NULL));
+#ifdef VERSION
+  printf("Build Version; %s \n", VERSION);
+#endif
+  printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_clist_node_size - Check that nodes pack into 8 bytes\n");
+        printf(" 2. test_clist_insert - Test basic list insert operations\n");
+        printf(" 3. test_clist_insert_after_before - Test insert after and before a given node\n");
+        printf(" 4. test_clist_delete - Test delete operation\n");
+        printf(" 5. test_clist_search - Test search for a particular node\n");
+        printf(" 6. test_clist_display - Test the display functionality\n");
+        printf(" 7. test_clist_relocation - Test a list in a pool mapped at another address\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 8. test_clist_insert_loop - Test multiple insertions\n");
+        printf(" 9. test_clist_delete_loop - Test multiple deletions\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_clist_node_size();
+        test_clist_insert();
+        test_clist_insert_after_before();
+        test_clist_delete();
+        test_clist_search();
+        test_clist_display();
+        test_clist_relocation();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_clist_insert_loop(1000);
+        test_clist_delete_loop(1000);
+        break;
+    case 1:
+        test_clist_node_size();
+        break;
+    case 2:
+        test_clist_insert();
+        break;
+    case 3:
+        test_clist_insert_after_before();
+        break;
+    case 4:
+        test_clist_delete();
+        break;
+    case 5:
+        test_clist_search();
+        break;
+    case 6:
+        test_clist_display();
+        break;
+    case 7:
+        test_clist_relocation();
+        break;
+    case 8:
+        test_clist_insert_loop(1000);
+        break;
+    case 9:
+        test_clist_delete_loop(1000);
+        break;
+
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <assert.h>
 #include <time.h>
+#include <unistd.h>
 
 
 #include "common_defs.h"
@@ -139,8 +140,8 @@ void test_list_display()
     printf_yellow(" Testing list_display ... \n");
     Node *head = NULL;
 
-    int Nnodes=3+rand()%10;
     int entries=5+rand()%5;
+    int Nnodes=entries+rand()%10; // The pool must hold every entry
     
     list_init(&head, sizeof(Node) * Nnodes);
 
@@ -166,7 +167,7 @@ void test_list_display()
 
     char *stringFull=malloc(1024);
     char *string2Last=malloc(1024);
-    char *string1third=malloc(1024);
+    char *string1third=calloc(1, 1024); // Filled by strncpy, which does not terminate
     char *stringRandom=malloc(1024);
     
     sprintf(stringFull, "[");
@@ -184,7 +185,13 @@ void test_list_display()
 	values[i]=0;
       }
     for(int k=0;k<entries;k++){
-      values[k]=10+rand()%90;
+      // Distinct values, so that searching for a value finds its own node
+      int unique;
+      do {
+	values[k]=10+rand()%90;
+	unique=1;
+	for (int j=0;j<k;j++) unique &= values[j]!=values[k];
+      } while (!unique);
       list_insert(&head, values[k]);
       if (k==randomLow && !Low){
 	Low=list_search(&head, values[k]);
@@ -261,7 +268,7 @@ void test_list_display()
 #endif
 
 
-    char *blob=malloc(1024);
+    char *blob=calloc(1, 1024);
     strncpy(blob, start, LenToLast-LenToFirst);
     
     sprintf(stringRandom,"[%s",blob);
@@ -482,6 +489,1503 @@ void test_list_edge_cases()
     printf_green("[PASS].\n");
 }
 
+// ********* List handle *********
+
+void test_list_handle()
+{
+    printf_yellow(" Testing List handle operations ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * 6);
+    my_assert(list.head == NULL && list.tail == NULL && list_length(&list) == 0);
+
+    list_append(&list, 20);
+    list_append(&list, 40);
+    list_prepend(&list, 10);
+    my_assert(list.head->data == 10 && list.tail->data == 40);
+
+    list_add_after(&list, list.tail, 50); // After the tail moves the tail
+    my_assert(list.tail->data == 50);
+    list_add_before(&list, list_find(&list, 40), 30);
+    list_add_before(&list, list.head, 5); // Before the head moves the head
+    my_assert(list.head->data == 5);
+    my_assert(list_length(&list) == 6);
+
+    int expected[] = {5, 10, 20, 30, 40, 50};
+    Node *current = list.head;
+    for (int i = 0; i < 6; i++)
+    {
+        my_assert(current->data == expected[i]);
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    list_remove(&list, 50); // Removing the tail moves the tail back
+    my_assert(list.tail->data == 40 && list.tail->next == NULL);
+    list_remove(&list, 5);
+    my_assert(list.head->data == 10);
+    list_remove(&list, 99); // Not in the list
+    my_assert(list_length(&list) == 4);
+    my_assert(list_length(&list) == (size_t)list_count_nodes(&list.head));
+
+    list_remove(&list, 10);
+    list_remove(&list, 20);
+    list_remove(&list, 30);
+    list_remove(&list, 40);
+    my_assert(list.head == NULL && list.tail == NULL && list_length(&list) == 0);
+    list_append(&list, 60); // Appending to a list that became empty
+    my_assert(list.head == list.tail && list.head->data == 60);
+
+    list_destroy(&list);
+    my_assert(list.head == NULL && list_length(&list) == 0);
+    printf_green("[PASS].\n");
+}
+
+void test_list_append_loop(int count)
+{
+    printf_yellow(" Testing list_append loop ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_append(&list, i);
+    }
+    my_assert(list_length(&list) == (size_t)count);
+    my_assert(list.tail->data == (uint16_t)(count - 1));
+
+    Node *current = list.head;
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(current->data == (uint16_t)i);
+        current = current->next;
+    }
+
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Checks a List against a model array, including its tail, count and the
+// first match for every value in [0, domain).
+void assert_list_matches(List *list, const int *model, int count, int domain)
+{
+    Node *prev = NULL;
+    Node *current = list->head;
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(current != NULL && current->data == model[i]);
+        my_assert(list_prev(list, current) == prev);
+        if (i == count - 1)
+            my_assert(list->tail == current);
+        prev = current;
+        current = current->next;
+    }
+    my_assert(current == NULL);
+    my_assert(list_length(list) == (size_t)count);
+    if (count == 0)
+        my_assert(list->head == NULL && list->tail == NULL);
+
+    for (int value = 0; value < domain; value++)
+    {
+        my_assert(list_find(list, value) == list_search(&list->head, value));
+    }
+}
+
+void test_list_index()
+{
+    printf_yellow(" Testing list value index ---> ");
+    enum { OPS = 5000, MAX = 64, DOMAIN = 12 };
+    List list;
+    list_create(&list, sizeof(Node) * MAX + 8192);
+    list_append(&list, 3);
+    list_append(&list, 3);
+    my_assert(list_index_enable(&list)); // Built from the nodes already present
+    my_assert(list_find(&list, 3) == list.head);
+
+    // Random operations on a small value domain, so that values repeat
+    int model[MAX] = {3, 3};
+    int count = 2;
+    for (int op = 0; op < OPS; op++)
+    {
+        int value = rand() % DOMAIN;
+        int choice = rand() % 5;
+        if (count == MAX)
+            choice = 4;
+        if (count == 0)
+            choice = 0;
+
+        if (choice == 0 || choice == 1)
+        {
+            if (choice == 0)
+            {
+                list_append(&list, value);
+                model[count] = value;
+            }
+            else
+            {
+                list_prepend(&list, value);
+                memmove(model + 1, model, count * sizeof(int));
+                model[0] = value;
+            }
+            count++;
+        }
+        else if (choice == 2 || choice == 3)
+        {
+            int at = rand() % count;
+            Node *node = list.head;
+            for (int i = 0; i < at; i++)
+                node = node->next;
+            int pos = (choice == 2) ? at + 1 : at;
+            if (choice == 2)
+                list_add_after(&list, node, value);
+            else
+                list_add_before(&list, node, value);
+            memmove(model + pos + 1, model + pos, (count - pos) * sizeof(int));
+            model[pos] = value;
+            count++;
+        }
+        else
+        {
+            list_remove(&list, value);
+            for (int i = 0; i < count; i++)
+            {
+                if (model[i] == value)
+                {
+                    memmove(model + i, model + i + 1, (count - i - 1) * sizeof(int));
+                    count--;
+                    break;
+                }
+            }
+        }
+        assert_list_matches(&list, model, count, DOMAIN);
+    }
+
+    my_assert(list.index != NULL); // The pool had room for the index throughout
+    list_index_disable(&list);
+    assert_list_matches(&list, model, count, DOMAIN);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_index_loop(int count)
+{
+    printf_yellow(" Testing indexed search and remove loop ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count + 64 * count);
+    my_assert(list_index_enable(&list));
+    for (int i = 0; i < count; i++)
+    {
+        list_append(&list, i);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        Node *found = list_find(&list, i);
+        my_assert(found != NULL && found->data == i);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        list_remove(&list, i);
+    }
+    my_assert(list.head == NULL && list_length(&list) == 0);
+
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Checks the value index of a long list against a walk over it.
+void assert_index_consistent(List *list, int domain)
+{
+    Node **first = calloc(domain, sizeof(Node *));
+    my_assert(first != NULL);
+    Node *prev = NULL;
+    size_t count = 0;
+    for (Node *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(list_prev(list, node) == prev);
+        if (first[node->data] == NULL)
+            first[node->data] = node;
+        prev = node;
+        count++;
+    }
+    my_assert(list->tail == prev);
+    my_assert(list_length(list) == count);
+    for (int value = 0; value < domain; value++)
+    {
+        my_assert(list_find(list, value) == first[value]);
+    }
+    free(first);
+}
+
+void test_list_index_duplicates(int count)
+{
+    printf_yellow(" Testing indexed inserts and removes of repeated values ---> ");
+    enum { DOMAIN = 1000 };
+    List list;
+    list_create(&list, sizeof(Node) * count * 3);
+    my_assert(list_index_enable(&list));
+    Node **nodes = malloc(count * sizeof(Node *));
+    my_assert(nodes != NULL);
+
+    // Each value ends up count / DOMAIN times, inserted at either end and
+    // before and after random nodes, so most inserts land among equal values
+    list_append(&list, 0);
+    nodes[0] = list.head;
+    for (int i = 1; i < count; i++)
+    {
+        uint16_t value = i % DOMAIN;
+        Node *at = nodes[rand() % i];
+        switch (rand() % 4)
+        {
+        case 0:
+            list_prepend(&list, value);
+            nodes[i] = list.head;
+            break;
+        case 1:
+            list_append(&list, value);
+            nodes[i] = list.tail;
+            break;
+        case 2:
+            list_add_after(&list, at, value);
+            nodes[i] = at->next;
+            break;
+        default:
+            list_add_before(&list, at, value);
+            nodes[i] = list_prev(&list, at);
+            break;
+        }
+        my_assert(nodes[i] != NULL && nodes[i]->data == value);
+    }
+    my_assert(list.index != NULL);
+    assert_index_consistent(&list, DOMAIN);
+
+    // Remove half of the nodes in random order, then a quarter by value
+    for (int i = count - 1; i > 0; i--)
+    {
+        int j = rand() % (i + 1);
+        Node *swap = nodes[i];
+        nodes[i] = nodes[j];
+        nodes[j] = swap;
+    }
+    for (int i = 0; i < count / 2; i++)
+    {
+        list_remove_node(&list, nodes[i]);
+    }
+    for (int i = 0; i < count / 4; i++)
+    {
+        list_remove(&list, i % DOMAIN);
+    }
+    my_assert(list_length(&list) == (size_t)(count - count / 2 - count / 4));
+    my_assert(list.index != NULL);
+    assert_index_consistent(&list, DOMAIN);
+
+    free(nodes);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Checks next and prev links of a doubly linked list against each other.
+void assert_doubly_links(List *list)
+{
+    DNode *prev = NULL;
+    size_t count = 0;
+    for (Node *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(((DNode *)node)->prev == prev);
+        my_assert(list_prev(list, node) == (Node *)prev);
+        prev = (DNode *)node;
+        count++;
+    }
+    my_assert(list->tail == (Node *)prev);
+    my_assert(count == list_length(list));
+}
+
+void test_list_create_twice()
+{
+    printf_yellow(" Testing list_create while the default pool is in use ---> ");
+    List first, second;
+    list_create(&first, sizeof(Node) * 4 + 256);
+    list_append(&first, 1);
+    list_append(&first, 2);
+    list_append(&first, 3);
+
+    // The second list must not re-initialize the pool the first one uses
+    list_create(&second, sizeof(Node) * 4 + 256);
+    my_assert(second.pool != NULL && second.ownsPool);
+    list_append(&second, 7);
+    list_append(&second, 8);
+    list_append(&second, 9);
+    list_remove(&second, 8);
+
+    char buffer[64];
+    list_format(&first.head, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[1, 2, 3]") == 0 && list_length(&first) == 3);
+    list_format(&second.head, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[7, 9]") == 0);
+
+    list_destroy(&second);
+    my_assert(mem_initialized());
+    list_format(&first.head, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[1, 2, 3]") == 0);
+    list_destroy(&first);
+    my_assert(!mem_initialized());
+    printf_green("[PASS].\n");
+}
+
+void test_list_doubly()
+{
+    printf_yellow(" Testing doubly linked List operations ---> ");
+    List list;
+    list_create_ex(&list, sizeof(DNode) * 8 + 512, LIST_DOUBLY); // Room for the index
+    list_append(&list, 20);
+    list_append(&list, 40);
+    list_prepend(&list, 10);
+    list_add_after(&list, list.tail, 50);
+    list_add_before(&list, list_find(&list, 40), 30);
+    list_add_before(&list, list.head, 5);
+    assert_doubly_links(&list);
+
+    // Walk backwards from the tail
+    int expected[] = {50, 40, 30, 20, 10, 5};
+    Node *current = list.tail;
+    for (int i = 0; i < 6; i++)
+    {
+        my_assert(current->data == expected[i]);
+        current = list_prev(&list, current);
+    }
+    my_assert(current == NULL);
+
+    char buffer[64];
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    stdout = fp;
+    list_print_reverse(&list);
+    fflush(fp);
+    rewind(fp);
+    size_t length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+    buffer[length] = '\0';
+    fclose(fp);
+    stdout = original_stdout;
+    my_assert(strcmp(buffer, "[50, 40, 30, 20, 10, 5]") == 0);
+
+    list_remove_node(&list, list_find(&list, 30)); // Middle
+    list_remove_node(&list, list.head);            // Head
+    list_remove_node(&list, list.tail);            // Tail
+    assert_doubly_links(&list);
+    my_assert(list.head->data == 10 && list.tail->data == 40);
+
+    // The index and prev pointers are kept together
+    my_assert(list_index_enable(&list));
+    list_add_before(&list, list.tail, 10);
+    list_remove(&list, 10);
+    assert_doubly_links(&list);
+    my_assert(list.head->data == 20 && list_find(&list, 10) == list.head->next);
+
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_doubly_loop(int count)
+{
+    printf_yellow(" Testing doubly linked insert before and remove node loop ---> ");
+    List list;
+    list_create_ex(&list, sizeof(DNode) * count, LIST_DOUBLY);
+    list_append(&list, 0);
+
+    // Insert before the tail each time, which a singly linked list would
+    // have to find by walking from the head
+    for (int i = 1; i < count; i++)
+    {
+        list_add_before(&list, list.tail, i);
+    }
+    my_assert(list_length(&list) == (size_t)count);
+    my_assert(list.tail->data == 0 && list_prev(&list, list.tail)->data == (uint16_t)(count - 1));
+    assert_doubly_links(&list);
+
+    // Remove from the back
+    for (int i = 0; i < count; i++)
+    {
+        list_remove_node(&list, list.tail);
+    }
+    my_assert(list.head == NULL && list.tail == NULL && list_length(&list) == 0);
+
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Captures what a List print function writes to stdout into a malloc'd
+// buffer, and returns its length.
+static size_t capture_list_print(void (*print)(List *), List *list, char **text)
+{
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    stdout = fp;
+    print(list);
+    fflush(fp);
+    stdout = original_stdout;
+
+    long length = ftell(fp);
+    rewind(fp);
+    *text = (char *)malloc(length + 1);
+    my_assert(*text != NULL);
+    my_assert(fread(*text, 1, length, fp) == (size_t)length);
+    (*text)[length] = '\0';
+    fclose(fp);
+    return length;
+}
+
+void test_list_print_reverse(int count)
+{
+    printf_yellow(" Testing reverse printing against forward printing ---> ");
+    unsigned kinds[] = {0, LIST_DOUBLY};
+    for (int k = 0; k < 2; k++)
+    {
+        List list;
+        size_t nodeSize = kinds[k] & LIST_DOUBLY ? sizeof(DNode) : sizeof(Node);
+        my_assert(list_create_pool(&list, nodeSize * count + 4096, kinds[k]));
+
+        char *text;
+        capture_list_print(list_print_reverse, &list, &text);
+        my_assert(strcmp(text, "NULL") == 0);
+        free(text);
+
+        // Long enough for the output to span several formatting chunks
+        for (int i = 0; i < count; i++) list_prepend(&list, rand() % (UINT16_MAX + 1));
+        char *reversed;
+        size_t reversedLength = capture_list_print(list_print_reverse, &list, &reversed);
+
+        // The same values in the opposite order print the same text
+        List mirror;
+        my_assert(list_create_pool(&mirror, nodeSize * count + 4096, kinds[k]));
+        for (Node *current = list.head; current != NULL; current = current->next) list_prepend(&mirror, current->data);
+        char *forward;
+        size_t forwardLength = capture_list_print(list_print, &mirror, &forward);
+        my_assert(reversedLength == forwardLength);
+        my_assert(memcmp(reversed, forward, forwardLength) == 0);
+
+        free(reversed);
+        free(forward);
+        list_destroy(&mirror);
+        list_destroy(&list);
+    }
+    printf_green("[PASS].\n");
+}
+
+void test_list_from_array()
+{
+    printf_yellow(" Testing list_from_array and list_append_array ---> ");
+    uint16_t values[] = {7, 3, 9, 3, 1};
+    List list;
+    my_assert(list_from_array(&list, sizeof(Node) * 9 + 512, values, 5)); // Room for the index
+    my_assert(list_length(&list) == 5 && list.tail->data == 1);
+
+    // Nodes lie next to each other in list order
+    Node *current = list.head;
+    for (int i = 0; i < 5; i++)
+    {
+        my_assert(current->data == values[i]);
+        if (i < 4)
+            my_assert(current->next == current + 1);
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    // Appending after single nodes, and to an indexed list
+    list_remove(&list, 9);
+    my_assert(list_index_enable(&list));
+    uint16_t more[] = {5, 9};
+    my_assert(list_append_array(&list, more, 2));
+    my_assert(list_length(&list) == 6 && list.tail->data == 9);
+    my_assert(list_find(&list, 9) == list.tail && list_find(&list, 5)->next == list.tail);
+    my_assert(list_append_array(&list, more, 0));
+
+    // No room: the list is left as it was
+    uint16_t many[32] = {0};
+    my_assert(!list_append_array(&list, many, 32));
+    my_assert(list_length(&list) == 6);
+    list_destroy(&list);
+
+    // Doubly linked nodes get their prev pointers
+    list_create_ex(&list, sizeof(DNode) * 5, LIST_DOUBLY);
+    my_assert(list_append_array(&list, values, 5));
+    my_assert(list_prev(&list, list.tail)->data == 3 && list_prev(&list, list.head) == NULL);
+    my_assert(list_prev(&list, list.head->next) == list.head);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_append_array_loop(int count)
+{
+    printf_yellow(" Testing list_from_array with many values ---> ");
+    uint16_t *values = malloc(count * sizeof(uint16_t));
+    my_assert(values != NULL);
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = (uint16_t)(i * 7);
+    }
+
+    List list;
+    my_assert(list_from_array(&list, sizeof(Node) * count * 2, values, count));
+    my_assert(list_append_array(&list, values, count));
+    my_assert(list_length(&list) == 2 * (size_t)count);
+    my_assert(list_count_nodes(&list.head) == 2 * count);
+    Node *current = list.head;
+    for (int i = 0; i < 2 * count; i++)
+    {
+        my_assert(current->data == values[i % count]);
+        current = current->next;
+    }
+
+    // Removing a node frees only that node
+    list_remove(&list, values[count / 2]);
+    my_assert(list_length(&list) == 2 * (size_t)count - 1);
+    list_append(&list, 1);
+    my_assert(list.tail->data == 1);
+
+    list_destroy(&list);
+    free(values);
+    printf_green("[PASS].\n");
+}
+
+// Predicate for list_delete_if: values divisible by *ctx.
+bool is_multiple_of(uint16_t data, void *ctx)
+{
+    return data % *(int *)ctx == 0;
+}
+
+// Checks a list, its tail and its count against expected values, and prev
+// pointers if it is doubly linked.
+void assert_list_equals(List *list, const uint16_t *expected, size_t count)
+{
+    Node *prev = NULL;
+    Node *current = list->head;
+    for (size_t i = 0; i < count; i++)
+    {
+        my_assert(current != NULL && current->data == expected[i]);
+        if (list->flags & LIST_DOUBLY)
+            my_assert(list_prev(list, current) == prev);
+        prev = current;
+        current = current->next;
+    }
+    my_assert(current == NULL && list->tail == prev && list_length(list) == count);
+}
+
+void test_list_delete_bulk()
+{
+    printf_yellow(" Testing list_delete_all, list_delete_if and list_delete_values ---> ");
+    uint16_t values[] = {4, 1, 4, 6, 9, 4, 2, 7, 4};
+    for (unsigned flags = 0; flags <= LIST_DOUBLY; flags += LIST_DOUBLY)
+    {
+        List list;
+        list_create_ex(&list, sizeof(DNode) * 9 + 1024, flags); // Room for the index
+        my_assert(list_append_array(&list, values, 9));
+        my_assert(list_index_enable(&list));
+
+        // Head, middle and tail occurrences
+        my_assert(list_delete_all(&list, 4) == 4);
+        uint16_t afterAll[] = {1, 6, 9, 2, 7};
+        assert_list_equals(&list, afterAll, 5);
+        my_assert(list_find(&list, 4) == NULL && list_find(&list, 9)->data == 9);
+        my_assert(list_delete_all(&list, 4) == 0);
+
+        int divisor = 3;
+        my_assert(list_delete_if(&list, is_multiple_of, &divisor) == 2);
+        uint16_t afterIf[] = {1, 2, 7};
+        assert_list_equals(&list, afterIf, 3);
+
+        uint16_t set[] = {7, 5, 1, 7};
+        my_assert(list_delete_values(&list, set, 4) == 2);
+        uint16_t afterSet[] = {2};
+        assert_list_equals(&list, afterSet, 1);
+        my_assert(list_find(&list, 2) == list.head);
+
+        my_assert(list_delete_values(&list, values + 6, 1) == 1);
+        my_assert(list.head == NULL && list.tail == NULL && list_length(&list) == 0);
+        my_assert(list_delete_all(&list, 2) == 0);
+        list_destroy(&list);
+    }
+    printf_green("[PASS].\n");
+}
+
+void test_list_delete_bulk_loop(int count)
+{
+    printf_yellow(" Testing bulk deletes on a long indexed list ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count + 64 * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_append(&list, i % 1000);
+    }
+    my_assert(list_index_enable(&list));
+
+    int divisor = 2;
+    my_assert(list_delete_if(&list, is_multiple_of, &divisor) == (size_t)count / 2);
+    uint16_t set[] = {1, 3, 5};
+    my_assert(list_delete_values(&list, set, 3) == 3 * (size_t)count / 1000);
+    my_assert(list_delete_all(&list, 999) == (size_t)count / 1000);
+    my_assert(list_length(&list) == (size_t)list_count_nodes(&list.head));
+    for (Node *current = list.head; current != NULL; current = current->next)
+    {
+        my_assert(current->data % 2 == 1 && current->data > 5 && current->data != 999);
+    }
+    my_assert(list_find(&list, 7) == list.head);
+
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// Builds the text list_display_range would print, with printf formatting.
+size_t reference_format(char *buffer, Node *startNode, Node *endNode)
+{
+    size_t length = sprintf(buffer, "[");
+    Node *stop = endNode ? endNode->next : NULL;
+    for (Node *current = startNode; current != stop; current = current->next)
+    {
+        length += sprintf(buffer + length, current == startNode ? "%d" : ", %d", current->data);
+    }
+    length += sprintf(buffer + length, "]");
+    return length;
+}
+
+// Adapts list_display to the callback type of capture_stdout.
+static void display_all(Node **head, Node *a, Node *b)
+{
+    (void)a;
+    (void)b;
+    list_display(head);
+}
+
+void test_list_format()
+{
+    printf_yellow(" Testing list_format and list_write ---> ");
+    Node *head = NULL;
+    list_init(&head, sizeof(Node) * 8);
+    char buffer[64];
+    char expected[64];
+
+    my_assert(list_format(&head, buffer, sizeof(buffer)) == 4 && strcmp(buffer, "NULL") == 0);
+    my_assert(list_format_range(&head, NULL, NULL, buffer, sizeof(buffer)) == 2 && strcmp(buffer, "[]") == 0);
+
+    uint16_t values[] = {0, 7, 65535, 10, 100, 4096};
+    for (int i = 0; i < 6; i++)
+    {
+        list_insert(&head, values[i]);
+    }
+    size_t length = reference_format(expected, head, NULL);
+    my_assert(strcmp(expected, "[0, 7, 65535, 10, 100, 4096]") == 0);
+    my_assert(list_format(&head, buffer, sizeof(buffer)) == length && strcmp(buffer, expected) == 0);
+
+    // Matches what list_display prints
+    capture_stdout(buffer, sizeof(buffer), display_all, &head, NULL, NULL);
+    my_assert(strcmp(buffer, expected) == 0);
+
+    Node *second = head->next;
+    Node *fourth = second->next->next;
+    length = reference_format(expected, second, fourth);
+    my_assert(list_format_range(&head, second, fourth, buffer, sizeof(buffer)) == length);
+    my_assert(strcmp(buffer, "[7, 65535, 10]") == 0);
+    capture_stdout(buffer, sizeof(buffer), list_display_range, &head, second, fourth);
+    my_assert(strcmp(buffer, expected) == 0);
+
+    // Too small a buffer: cut short and terminated, full length returned
+    char small[6];
+    my_assert(list_format(&head, small, sizeof(small)) == strlen("[0, 7, 65535, 10, 100, 4096]"));
+    my_assert(strcmp(small, "[0, 7") == 0);
+    my_assert(list_format(&head, NULL, 0) == strlen("[0, 7, 65535, 10, 100, 4096]"));
+
+    // Writing to a file descriptor
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    my_assert(list_write_range(&head, second, fourth, fileno(fp)));
+    my_assert(list_write(&head, fileno(fp)));
+    rewind(fp);
+    length = fread(buffer, 1, sizeof(buffer) - 1, fp);
+    buffer[length] = '\0';
+    fclose(fp);
+    my_assert(strcmp(buffer, "[7, 65535, 10][0, 7, 65535, 10, 100, 4096]") == 0);
+    my_assert(!list_write(&head, -1));
+
+    list_cleanup(&head);
+    printf_green("[PASS].\n");
+}
+
+void test_list_format_loop(int count)
+{
+    printf_yellow(" Testing list_write and list_display with many nodes ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_append(&list, (uint16_t)(i * 37));
+    }
+
+    size_t size = 8 * (size_t)count + 3;
+    char *expected = malloc(size);
+    char *actual = malloc(size);
+    my_assert(expected != NULL && actual != NULL);
+    size_t length = reference_format(expected, list.head, NULL);
+    my_assert(list_format(&list.head, actual, size) == length && strcmp(actual, expected) == 0);
+
+    // Output spans many chunks, through a file descriptor and through stdout
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    my_assert(list_write(&list.head, fileno(fp)));
+    FILE *original_stdout = stdout;
+    stdout = fp;
+    list_display(&list.head);
+    fflush(fp);
+    stdout = original_stdout;
+    rewind(fp);
+    my_assert(fread(actual, 1, length, fp) == length && memcmp(actual, expected, length) == 0);
+    my_assert(fread(actual, 1, length, fp) == length && memcmp(actual, expected, length) == 0);
+    my_assert(fread(actual, 1, 1, fp) == 0);
+    fclose(fp);
+
+    free(expected);
+    free(actual);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_save_load()
+{
+    printf_yellow(" Testing list_save and list_load ---> ");
+    uint16_t values[] = {3, 65535, 0, 3, 42};
+    List list;
+    my_assert(list_from_array(&list, sizeof(Node) * 16, values, 5));
+
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    int fd = fileno(fp);
+    my_assert(list_save(&list, fd));
+    list_destroy(&list);
+
+    // Header, then the packed values
+    ListFileHeader header;
+    my_assert(pread(fd, &header, sizeof(header), 0) == sizeof(header));
+    my_assert(header.magic == LIST_FILE_MAGIC && header.version == LIST_FILE_VERSION && header.count == 5);
+    my_assert(lseek(fd, 0, SEEK_END) == (off_t)(sizeof(header) + sizeof(values)));
+
+    // Mapped and rebuilt in one contiguous block, from the current position
+    list_create(&list, sizeof(Node) * 16);
+    my_assert(lseek(fd, 0, SEEK_SET) == 0);
+    my_assert(list_load(&list, fd));
+    my_assert(lseek(fd, 0, SEEK_CUR) == (off_t)(sizeof(header) + sizeof(values)));
+    my_assert(list_length(&list) == 5 && list.tail->data == 42);
+    Node *current = list.head;
+    for (int i = 0; i < 5; i++)
+    {
+        my_assert(current->data == values[i]);
+        my_assert(current->next == NULL || current->next == current + 1);
+        current = current->next;
+    }
+
+    // A second load appends
+    my_assert(!list_load(&list, fd)); // End of the file
+    my_assert(lseek(fd, 0, SEEK_SET) == 0);
+    my_assert(list_load(&list, fd));
+    my_assert(list_length(&list) == 10 && list.tail->data == 42);
+    my_assert(lseek(fd, 0, SEEK_SET) == 0);
+
+    // Corrupted values and headers are rejected and leave the list alone
+    uint16_t bad = 4;
+    my_assert(pwrite(fd, &bad, sizeof(bad), sizeof(header)) == sizeof(bad));
+    my_assert(!list_load(&list, fd));
+    my_assert(pwrite(fd, &values[0], sizeof(bad), sizeof(header)) == sizeof(bad));
+    my_assert(ftruncate(fd, sizeof(header) + sizeof(values) - 2) == 0);
+    my_assert(!list_load(&list, fd));
+    my_assert(pwrite(fd, "XIST", 4, 0) == 4);
+    my_assert(!list_load(&list, fd));
+    my_assert(list_length(&list) == 10);
+    list_destroy(&list);
+    fclose(fp);
+
+    // Lists saved after other data and after each other, at an offset within
+    // a page, past a page, and one that is not aligned and so is read
+    off_t offsets[] = {40, 4096 + 8, 3};
+    for (int i = 0; i < 3; i++)
+    {
+        fp = tmpfile();
+        my_assert(fp != NULL);
+        fd = fileno(fp);
+        my_assert(ftruncate(fd, offsets[i]) == 0 && lseek(fd, offsets[i], SEEK_SET) == offsets[i]);
+        my_assert(list_from_array(&list, sizeof(Node) * 16, values, 5));
+        my_assert(list_save(&list, fd));
+        list_append(&list, 7);
+        my_assert(list_save(&list, fd));
+        list_destroy(&list);
+        off_t end = lseek(fd, 0, SEEK_CUR);
+
+        list_create(&list, sizeof(Node) * 16);
+        my_assert(lseek(fd, offsets[i], SEEK_SET) == offsets[i]);
+        my_assert(list_load(&list, fd) && list_length(&list) == 5);
+        my_assert(lseek(fd, 0, SEEK_CUR) == (off_t)(offsets[i] + sizeof(header) + sizeof(values)));
+        my_assert(list_load(&list, fd) && list_length(&list) == 11);
+        my_assert(list.head->data == values[0] && list.tail->data == 7);
+        my_assert(lseek(fd, 0, SEEK_CUR) == end);
+        my_assert(!list_load(&list, fd) && list_length(&list) == 11);
+        list_destroy(&list);
+        fclose(fp);
+    }
+
+    // A read list that turns out corrupt or short is taken out again, after
+    // several chunks were appended, and the position goes back to its start
+    static uint16_t many[20000];
+    for (int i = 0; i < 20000; i++)
+    {
+        many[i] = i % 300;
+    }
+    fp = tmpfile();
+    my_assert(fp != NULL);
+    fd = fileno(fp);
+    my_assert(ftruncate(fd, 3) == 0 && lseek(fd, 3, SEEK_SET) == 3);
+    my_assert(list_from_array(&list, sizeof(Node) * 20000, many, 20000));
+    my_assert(list_save(&list, fd));
+    list_destroy(&list);
+    my_assert(pwrite(fd, &bad, sizeof(bad), 3 + sizeof(header) + sizeof(many) - 2) == sizeof(bad));
+
+    my_assert(list_create_pool(&list, sizeof(Node) * 60000, 0));
+    list_append(&list, 1);
+    my_assert(list_index_enable(&list));
+    my_assert(lseek(fd, 3, SEEK_SET) == 3);
+    my_assert(!list_load(&list, fd) && lseek(fd, 0, SEEK_CUR) == 3);
+    my_assert(list_length(&list) == 1 && list.head == list.tail && list.head->next == NULL);
+    assert_index_consistent(&list, 300);
+    my_assert(ftruncate(fd, 3 + sizeof(header) + sizeof(many) - 2) == 0);
+    my_assert(!list_load(&list, fd) && lseek(fd, 0, SEEK_CUR) == 3);
+    my_assert(list_length(&list) == 1 && list.head == list.tail);
+    assert_index_consistent(&list, 300);
+    fclose(fp);
+
+    // A count far beyond the data that follows is not trusted for a buffer
+    int pipefd[2];
+    my_assert(pipe(pipefd) == 0);
+    header.count = UINT64_MAX / 4;
+    my_assert(write(pipefd[1], &header, sizeof(header)) == sizeof(header));
+    my_assert(write(pipefd[1], values, sizeof(values)) == sizeof(values));
+    close(pipefd[1]);
+    my_assert(!list_load(&list, pipefd[0]) && list_length(&list) == 1);
+    close(pipefd[0]);
+    list_destroy(&list);
+
+    // Pipes are read instead of mapped; an empty list round-trips too
+    my_assert(pipe(pipefd) == 0);
+    list_create(&list, sizeof(Node) * 16);
+    my_assert(list_save(&list, pipefd[1]));
+    list_append(&list, 9);
+    list_append(&list, 8);
+    my_assert(list_save(&list, pipefd[1]));
+    close(pipefd[1]);
+    list_destroy(&list);
+
+    list_create(&list, sizeof(Node) * 16);
+    my_assert(list_load(&list, pipefd[0]) && list_length(&list) == 0);
+    my_assert(list_load(&list, pipefd[0]) && list_length(&list) == 2);
+    my_assert(list.head->data == 9 && list.tail->data == 8);
+    my_assert(!list_load(&list, pipefd[0])); // End of the data
+    close(pipefd[0]);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_save_load_loop(int count)
+{
+    printf_yellow(" Testing list_save and list_load with many nodes ---> ");
+    List list;
+    list_create(&list, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_append(&list, (uint16_t)(i * 31 + 7));
+    }
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    my_assert(list_save(&list, fileno(fp)));
+    list_destroy(&list);
+
+    list_create(&list, sizeof(Node) * count);
+    my_assert(lseek(fileno(fp), 0, SEEK_SET) == 0);
+    my_assert(list_load(&list, fileno(fp)));
+    my_assert(list_length(&list) == (size_t)count);
+    Node *current = list.head;
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(current->data == (uint16_t)(i * 31 + 7));
+        current = current->next;
+    }
+    my_assert(current == NULL);
+
+    // No room in the pool for a second copy
+    my_assert(lseek(fileno(fp), 0, SEEK_SET) == 0);
+    my_assert(!list_load(&list, fileno(fp)));
+    my_assert(lseek(fileno(fp), 0, SEEK_CUR) == 0);
+    my_assert(list_length(&list) == (size_t)count);
+    fclose(fp);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+// qsort comparator for uint16_t values.
+int compare_uint16(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+void test_list_sort()
+{
+    printf_yellow(" Testing list_sort in merge and counting modes ---> ");
+    uint16_t values[] = {5, 3, 65535, 3, 0, 5, 1, 3};
+    uint16_t sorted[] = {0, 1, 3, 3, 3, 5, 5, 65535};
+    for (int mode = LIST_SORT_MERGE; mode <= LIST_SORT_COUNTING; mode++)
+    {
+        for (unsigned flags = 0; flags <= LIST_DOUBLY; flags += LIST_DOUBLY)
+        {
+            List list;
+            list_create_ex(&list, sizeof(DNode) * 8 + 1024, flags);
+            list_sort(&list, mode); // Empty
+            my_assert(list.head == NULL && list.tail == NULL);
+            list_append(&list, 7);
+            list_sort(&list, mode); // One node
+            my_assert(list.head == list.tail && list.head->data == 7);
+            list_remove(&list, 7);
+
+            my_assert(list_append_array(&list, values, 8));
+            my_assert(list_index_enable(&list));
+            Node *threes[3];
+            for (Node *current = list.head, **next = threes; current != NULL; current = current->next)
+            {
+                if (current->data == 3)
+                    *next++ = current;
+            }
+
+            list_sort(&list, mode);
+            assert_list_equals(&list, sorted, 8);
+            my_assert(list_find(&list, 3)->data == 3 && list_find(&list, 65535) == list.tail);
+            list_remove(&list, 0);
+            my_assert(list.head->data == 1);
+            if (mode == LIST_SORT_MERGE)
+            {
+                // Stable: equal values keep their order
+                my_assert(list.head->next == threes[0]);
+                my_assert(threes[0]->next == threes[1] && threes[1]->next == threes[2]);
+            }
+            list_destroy(&list);
+        }
+    }
+    printf_green("[PASS].\n");
+}
+
+void test_list_sort_loop(int count)
+{
+    printf_yellow(" Testing list_sort with many random values ---> ");
+    uint16_t *values = malloc(count * sizeof(uint16_t));
+    my_assert(values != NULL);
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = (uint16_t)rand();
+    }
+    for (int mode = LIST_SORT_MERGE; mode <= LIST_SORT_COUNTING; mode++)
+    {
+        List list;
+        my_assert(list_from_array(&list, sizeof(Node) * count, values, count));
+        list_sort(&list, mode);
+        if (mode == LIST_SORT_MERGE)
+            qsort(values, count, sizeof(uint16_t), compare_uint16);
+        assert_list_equals(&list, values, count);
+        list_destroy(&list);
+    }
+    free(values);
+    printf_green("[PASS].\n");
+}
+
+// Checks that nodes first to last sit back to back in memory.
+bool is_contiguous(List *list, Node *first, Node *last)
+{
+    size_t size = (list->flags & LIST_DOUBLY) ? sizeof(DNode) : sizeof(Node);
+    for (Node *current = first; current != last; current = current->next)
+    {
+        if ((char *)current->next != (char *)current + size)
+            return false;
+    }
+    return true;
+}
+
+void test_list_compact()
+{
+    printf_yellow(" Testing list_compact and list_compact_step ---> ");
+    uint16_t expected[40];
+    for (unsigned flags = 0; flags <= LIST_DOUBLY; flags += LIST_DOUBLY)
+    {
+        List list;
+        list_create_ex(&list, sizeof(DNode) * 40 * 3 + 4096, flags); // Room for the index
+        my_assert(list_compact(&list)); // Empty
+        my_assert(list.head == NULL && list.tail == NULL);
+
+        // Prepending leaves nodes in reverse address order
+        for (int i = 0; i < 40; i++)
+        {
+            list_prepend(&list, (uint16_t)(i * 3));
+            expected[39 - i] = (uint16_t)(i * 3);
+        }
+        my_assert(list_index_enable(&list));
+        my_assert(!is_contiguous(&list, list.head, list.tail));
+
+        my_assert(list_compact(&list));
+        my_assert(is_contiguous(&list, list.head, list.tail));
+        assert_list_equals(&list, expected, 40);
+        my_assert(list_find(&list, 0) == list.tail && list_find(&list, 117) == list.head);
+        my_assert(list_find(&list, 60)->data == 60);
+        list_remove(&list, 60); // Index still knows the predecessors
+        list_remove(&list, 117);
+        list_remove(&list, 0);
+        memmove(expected + 19, expected + 20, 20 * sizeof(uint16_t));
+        assert_list_equals(&list, expected + 1, 37);
+
+        // In steps of 5, each step moves one contiguous run
+        for (int i = 0; i < 37; i++)
+        {
+            list_remove(&list, expected[i + 1]);
+            list_prepend(&list, expected[i + 1]);
+        }
+        for (int i = 0; i < 37; i++)
+        {
+            expected[i] = expected[i + 1];
+        }
+        for (int i = 0; i < 37 / 2; i++)
+        {
+            uint16_t swap = expected[i];
+            expected[i] = expected[36 - i];
+            expected[36 - i] = swap;
+        }
+        Node *cursor = NULL;
+        int steps = 0;
+        while (cursor != list.tail)
+        {
+            Node *before = cursor;
+            my_assert(list_compact_step(&list, &cursor, 5));
+            my_assert(is_contiguous(&list, before ? before->next : list.head, cursor));
+            steps++;
+        }
+        my_assert(steps == 8);
+        my_assert(list_compact_step(&list, &cursor, 5)); // Nothing left
+        assert_list_equals(&list, expected, 37);
+        for (int i = 0; i < 37; i++)
+        {
+            my_assert(list_find(&list, expected[i])->data == expected[i]);
+        }
+        list_destroy(&list);
+    }
+
+    // No room for a second copy of the nodes
+    List list;
+    list_create(&list, sizeof(Node) * 4);
+    for (int i = 0; i < 4; i++)
+    {
+        list_prepend(&list, (uint16_t)i);
+    }
+    Node *head = list.head;
+    my_assert(!list_compact(&list));
+    my_assert(list.head == head && list_length(&list) == 4);
+    list_remove(&list, 3);
+    head = list.head;
+    Node *cursor = NULL;
+    my_assert(list_compact_step(&list, &cursor, 1)); // Moves into the freed node
+    my_assert(cursor == list.head && cursor != head && cursor->data == 2);
+    uint16_t remaining[] = {2, 1, 0};
+    assert_list_equals(&list, remaining, 3);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_compact_loop(int count)
+{
+    printf_yellow(" Testing list_compact on a long churned list ---> ");
+    uint16_t *values = malloc(count * sizeof(uint16_t));
+    my_assert(values != NULL);
+    List list;
+    list_create_ex(&list, sizeof(DNode) * count * 2 + 1024, LIST_DOUBLY);
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = (uint16_t)rand();
+        list_append(&list, values[i]);
+    }
+    // Churn: drop every node at an odd position and insert a fresh one
+    // before every third node, scattering the nodes across the pool
+    int n = 0;
+    Node *current = list.head;
+    for (int i = 0; current != NULL; i++)
+    {
+        Node *next = current->next;
+        if (i % 2 == 1)
+        {
+            list_remove_node(&list, current);
+        }
+        else
+        {
+            if (i % 3 == 0)
+            {
+                list_add_before(&list, current, (uint16_t)i);
+                values[n++] = (uint16_t)i;
+            }
+            values[n++] = current->data;
+        }
+        current = next;
+    }
+    my_assert(!is_contiguous(&list, list.head, list.tail));
+
+    my_assert(list_compact(&list));
+    my_assert(is_contiguous(&list, list.head, list.tail));
+    assert_list_equals(&list, values, n);
+    list_destroy(&list);
+    free(values);
+    printf_green("[PASS].\n");
+}
+
+void test_list_pools()
+{
+    printf_yellow(" Testing lists with their own and shared pools ---> ");
+    uint16_t values[] = {8, 6, 7, 5, 3, 0, 9};
+    List main, own, shared1, shared2;
+    list_create(&main, sizeof(Node) * 7);
+    my_assert(list_create_pool(&own, sizeof(DNode) * 7 + 1024, LIST_DOUBLY)); // Room for the index
+    MemPool *pool = mem_pool_create(sizeof(Node) * 14);
+    my_assert(pool != NULL);
+    list_create_in(&shared1, pool, 0);
+    list_create_in(&shared2, pool, 0);
+
+    // Interleaved, every list gets the room of its own pool
+    for (int i = 0; i < 7; i++)
+    {
+        list_append(&main, values[i]);
+        list_append(&own, values[i]);
+        list_prepend(&shared1, values[i]);
+        list_append(&shared2, values[6 - i]);
+    }
+    my_assert(mem_alloc(1) == NULL && mem_pool_alloc(pool, 1) == NULL);
+    my_assert(list_index_enable(&own));
+    assert_list_equals(&main, values, 7);
+    assert_list_equals(&own, values, 7);
+    uint16_t reversed[] = {9, 0, 3, 5, 7, 6, 8};
+    assert_list_equals(&shared1, reversed, 7);
+    assert_list_equals(&shared2, reversed, 7);
+    list_sort(&own, LIST_SORT_MERGE);
+    my_assert(list_find(&own, 9) == own.tail && list_find(&main, 9) == main.tail);
+
+    // Destroying the own pool list leaves the others alone
+    list_destroy(&own);
+    my_assert(own.head == NULL && own.pool == NULL);
+    assert_list_equals(&main, values, 7);
+
+    // Destroying a shared list frees its nodes, but not the pool
+    list_destroy(&shared1);
+    list_remove(&shared2, 9);
+    list_append(&shared2, 1);
+    uint16_t moved[] = {0, 3, 5, 7, 6, 8, 1};
+    assert_list_equals(&shared2, moved, 7);
+    for (int i = 0; i < 7; i++)
+    {
+        my_assert(mem_pool_alloc(pool, sizeof(Node)) != NULL);
+    }
+    my_assert(mem_pool_alloc(pool, 1) == NULL);
+    list_destroy(&shared2);
+    mem_pool_destroy(pool);
+
+    // A list may share the default pool with one made by list_create
+    List guest;
+    list_remove(&main, 8);
+    list_create_in(&guest, NULL, 0);
+    list_append(&guest, 4);
+    my_assert(guest.head->data == 4 && mem_alloc(1) == NULL);
+    list_destroy(&guest);
+    assert_list_equals(&main, values + 1, 6);
+    list_destroy(&main);
+    printf_green("[PASS].\n");
+}
+
+void test_list_pools_loop(int lists, int count)
+{
+    printf_yellow(" Testing many lists with their own pools ---> ");
+    List *handles = malloc(lists * sizeof(List));
+    my_assert(handles != NULL);
+    for (int l = 0; l < lists; l++)
+    {
+        my_assert(list_create_pool(&handles[l], sizeof(Node) * count, 0));
+    }
+    for (int i = 0; i < count; i++)
+    {
+        for (int l = 0; l < lists; l++)
+        {
+            list_append(&handles[l], (uint16_t)(l + i));
+        }
+    }
+    for (int l = 0; l < lists; l++)
+    {
+        my_assert(list_length(&handles[l]) == (size_t)count);
+        my_assert(handles[l].head->data == (uint16_t)l);
+        my_assert(handles[l].tail->data == (uint16_t)(l + count - 1));
+        list_destroy(&handles[l]);
+    }
+    free(handles);
+    printf_green("[PASS].\n");
+}
+
+// Collects visited values, for list_for_each and list_visit_chunks.
+typedef struct Collected
+{
+    uint16_t *values;
+    size_t count;
+    size_t calls;
+} Collected;
+
+void collect_value(uint16_t data, void *ctx)
+{
+    Collected *collected = (Collected *)ctx;
+    collected->values[collected->count++] = data;
+    collected->calls++;
+}
+
+void collect_chunk(const uint16_t *values, size_t n, void *ctx)
+{
+    Collected *collected = (Collected *)ctx;
+    my_assert(n > 0);
+    memcpy(collected->values + collected->count, values, n * sizeof(uint16_t));
+    collected->count += n;
+    collected->calls++;
+}
+
+void test_list_for_each()
+{
+    printf_yellow(" Testing list_for_each and list_visit_chunks ---> ");
+    uint16_t values[1000], visited[1000];
+    for (int i = 0; i < 1000; i++)
+    {
+        values[i] = (uint16_t)(i * 7);
+    }
+    List list;
+    list_create_ex(&list, sizeof(DNode) * 1000, LIST_DOUBLY);
+    Collected collected = {visited, 0, 0};
+    list_for_each(&list, collect_value, &collected);
+    list_visit_chunks(&list, collect_chunk, &collected);
+    my_assert(collected.calls == 0);
+
+    list_append(&list, 5);
+    list_visit_chunks(&list, collect_chunk, &collected);
+    my_assert(collected.calls == 1 && visited[0] == 5);
+    list_remove(&list, 5);
+
+    my_assert(list_append_array(&list, values, 1000));
+    collected = (Collected){visited, 0, 0};
+    list_for_each(&list, collect_value, &collected);
+    my_assert(collected.count == 1000 && collected.calls == 1000);
+    my_assert(memcmp(visited, values, sizeof(values)) == 0);
+
+    // Chunks of 256 values, the last one shorter
+    memset(visited, 0, sizeof(visited));
+    collected = (Collected){visited, 0, 0};
+    list_visit_chunks(&list, collect_chunk, &collected);
+    my_assert(collected.count == 1000 && collected.calls == 4);
+    my_assert(memcmp(visited, values, sizeof(values)) == 0);
+    my_assert(list_count_nodes(&list.head) == 1000);
+    list_destroy(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_for_each_loop(int count)
+{
+    printf_yellow(" Testing list_visit_chunks on a long list ---> ");
+    uint16_t *values = malloc(count * sizeof(uint16_t));
+    uint16_t *visited = malloc(count * sizeof(uint16_t));
+    my_assert(values != NULL && visited != NULL);
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = (uint16_t)rand();
+    }
+    List list;
+    my_assert(list_from_array(&list, sizeof(Node) * count, values, count));
+    Collected collected = {visited, 0, 0};
+    list_visit_chunks(&list, collect_chunk, &collected);
+    my_assert(collected.count == (size_t)count);
+    my_assert(memcmp(visited, values, count * sizeof(uint16_t)) == 0);
+    my_assert(list_count_nodes(&list.head) == count);
+    list_destroy(&list);
+    free(values);
+    free(visited);
+    printf_green("[PASS].\n");
+}
+
+void test_list_set_ops()
+{
+    printf_yellow(" Testing list_merge, list_union, list_intersect and list_difference ---> ");
+    uint16_t a[] = {1, 3, 3, 5, 7, 9};
+    uint16_t b[] = {2, 3, 5, 5, 10};
+    for (unsigned flags = 0; flags <= LIST_DOUBLY; flags += LIST_DOUBLY)
+    {
+        MemPool *pool = mem_pool_create(sizeof(DNode) * 11 + 2048); // Room for the indexes
+        my_assert(pool != NULL);
+        List list, other;
+        list_create_in(&list, pool, flags);
+        list_create_in(&other, pool, flags);
+
+        // Merge relinks every node, equal values of list first
+        my_assert(list_append_array(&list, a, 6) && list_append_array(&other, b, 5));
+        my_assert(list_index_enable(&list));
+        Node *three = other.head->next;
+        my_assert(list_merge(&list, &other));
+        uint16_t merged[] = {1, 2, 3, 3, 3, 5, 5, 5, 7, 9, 10};
+        assert_list_equals(&list, merged, 11);
+        assert_list_equals(&other, NULL, 0);
+        my_assert(list.head->next->next->next->next == three && list_find(&list, 10) == list.tail);
+        list_destroy(&list);
+        list_create_in(&list, pool, flags);
+
+        // Union keeps the larger count of each value
+        my_assert(list_append_array(&list, a, 6) && list_append_array(&other, b, 5));
+        my_assert(list_union(&list, &other));
+        uint16_t united[] = {1, 2, 3, 3, 5, 5, 7, 9, 10};
+        assert_list_equals(&list, united, 9);
+        assert_list_equals(&other, NULL, 0);
+        list_destroy(&list);
+        list_create_in(&list, pool, flags);
+
+        // Intersection and difference leave the other list alone
+        my_assert(list_append_array(&list, a, 6) && list_append_array(&other, b, 5));
+        my_assert(list_intersect(&list, &other) == 4);
+        uint16_t common[] = {3, 5};
+        assert_list_equals(&list, common, 2);
+        assert_list_equals(&other, b, 5);
+        list_destroy(&list);
+        list_create_in(&list, pool, flags);
+        my_assert(list_append_array(&list, a, 6));
+        my_assert(list_index_enable(&list));
+        my_assert(list_difference(&list, &other) == 2);
+        uint16_t rest[] = {1, 3, 7, 9};
+        assert_list_equals(&list, rest, 4);
+        my_assert(list_find(&list, 3) == list.head->next && list_find(&list, 5) == NULL);
+        my_assert(list_intersect(&list, &list) == 0 && list_difference(&list, &list) == 4);
+        assert_list_equals(&list, NULL, 0);
+
+        // Lists of different pools or kinds are not relinked
+        List foreign;
+        my_assert(list_create_pool(&foreign, sizeof(DNode) * 2, flags));
+        list_append(&foreign, 4);
+        my_assert(!list_merge(&list, &foreign) && !list_union(&foreign, &other) && !list_merge(&other, &other));
+        my_assert(foreign.head->data == 4 && list_length(&other) == 5);
+        my_assert(list_difference(&other, &foreign) == 0 && list_intersect(&other, &foreign) == 5);
+        list_destroy(&foreign);
+        list_destroy(&list);
+        list_destroy(&other);
+        mem_pool_destroy(pool);
+    }
+    printf_green("[PASS].\n");
+}
+
+// Checks a list against counts of each value, in ascending order.
+void assert_list_counts(List *list, const uint32_t *counts, size_t range)
+{
+    Node *current = list->head;
+    size_t total = 0;
+    for (size_t value = 0; value < range; value++)
+    {
+        for (uint32_t k = 0; k < counts[value]; k++, total++)
+        {
+            my_assert(current != NULL && current->data == value);
+            current = current->next;
+        }
+    }
+    my_assert(current == NULL && list_length(list) == total);
+}
+
+// Fills a list with n random values below range, sorted, and counts them.
+void fill_sorted(List *list, uint16_t *values, size_t n, uint32_t *counts, size_t range)
+{
+    memset(counts, 0, range * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++)
+    {
+        values[i] = (uint16_t)(rand() % range);
+        counts[values[i]]++;
+    }
+    qsort(values, n, sizeof(uint16_t), compare_uint16);
+    my_assert(list_append_array(list, values, n));
+}
+
+void test_list_set_ops_loop(int count)
+{
+    printf_yellow(" Testing sorted set operations on long random lists ---> ");
+    enum { RANGE = 1024 };
+    uint16_t *values = malloc(count * sizeof(uint16_t));
+    uint32_t *countsA = malloc(RANGE * sizeof(uint32_t));
+    uint32_t *countsB = malloc(RANGE * sizeof(uint32_t));
+    my_assert(values != NULL && countsA != NULL && countsB != NULL);
+    // The nodes, and room for the index tables while they are rebuilt
+    MemPool *pool = mem_pool_create(sizeof(DNode) * count * 2 + (size_t)count * 32 * 24);
+    my_assert(pool != NULL);
+
+    for (int round = 0; round < 32; round++)
+    {
+        // Every operation with each list the longer one, balanced and far
+        // longer with indexes, for the probes
+        int op = round % 4;
+        bool unbalanced = (round / 4) & 1;
+        bool swap = (round / 8) & 1;
+        unsigned flags = (round / 16) ? LIST_DOUBLY : 0;
+        size_t n = (size_t)count;
+        size_t m = unbalanced ? (size_t)count / 100 : (size_t)count / 2 + rand() % (count / 2);
+        List list, other;
+        list_create_in(&list, pool, flags);
+        list_create_in(&other, pool, flags);
+        fill_sorted(&list, values, swap ? m : n, countsA, RANGE);
+        fill_sorted(&other, values, swap ? n : m, countsB, RANGE);
+        if (unbalanced)
+            my_assert(list_index_enable(&list) && list_index_enable(&other));
+
+        size_t deleted = 0;
+        for (size_t v = 0; v < RANGE; v++)
+        {
+            uint32_t a = countsA[v], b = countsB[v];
+            switch (op)
+            {
+            case 0:
+                countsA[v] = a + b;
+                break;
+            case 1:
+                countsA[v] = a > b ? a : b;
+                break;
+            case 2:
+                countsA[v] = a < b ? a : b;
+                break;
+            default:
+                countsA[v] = a > b ? a - b : 0;
+                break;
+            }
+            if (countsA[v] < a)
+                deleted += a - countsA[v];
+        }
+        if (op == 0)
+            my_assert(list_merge(&list, &other));
+        else if (op == 1)
+            my_assert(list_union(&list, &other));
+        else if (op == 2)
+            my_assert(list_intersect(&list, &other) == deleted);
+        else
+            my_assert(list_difference(&list, &other) == deleted);
+        assert_list_counts(&list, countsA, RANGE);
+        if (op >= 2)
+            assert_list_counts(&other, countsB, RANGE);
+        else
+            my_assert(other.head == NULL && list_length(&other) == 0);
+        if (list.head != NULL)
+            my_assert(list_find(&list, list.head->data) == list.head && list_find(&list, list.tail->data)->data == list.tail->data);
+        list_destroy(&list);
+        list_destroy(&other);
+    }
+    // Every node went back to the pool
+    my_assert(mem_pool_alloc(pool, sizeof(DNode) * count * 2) != NULL);
+    mem_pool_destroy(pool);
+    free(values);
+    free(countsA);
+    free(countsB);
+    printf_green("[PASS].\n");
+}
+
 // Main function to run all tests
 int main(int argc, char *argv[])
 {
@@ -512,6 +2016,35 @@ int main(int argc, char *argv[])
         printf(" 12. test_list_delete_loop - Test multiple detelions\n");
         printf(" 13. test_list_search_loop - Test multiple search\n");
         printf(" 14. test_list_edge_cases - Test edge cases\n");
+
+        printf("\nList handle:\n");
+        printf(" 15. test_list_handle - Test List handle operations\n");
+        printf(" 16. test_list_append_loop - Test multiple constant time appends\n");
+        printf(" 17. test_list_index - Test the value index against a model\n");
+        printf(" 18. test_list_index_loop - Test multiple indexed searches and removals\n");
+        printf(" 19. test_list_doubly - Test doubly linked List operations and reverse iteration\n");
+        printf(" 20. test_list_doubly_loop - Test multiple constant time inserts before and removals\n");
+        printf(" 21. test_list_from_array - Test building lists from arrays\n");
+        printf(" 22. test_list_append_array_loop - Test building a long list from an array\n");
+        printf(" 23. test_list_delete_bulk - Test deleting many nodes in one pass\n");
+        printf(" 24. test_list_delete_bulk_loop - Test bulk deletes on a long list\n");
+        printf(" 25. test_list_format - Test buffered formatting into buffers and file descriptors\n");
+        printf(" 26. test_list_format_loop - Test buffered output of a long list\n");
+        printf(" 27. test_list_save_load - Test saving and loading the binary list format\n");
+        printf(" 28. test_list_save_load_loop - Test saving and loading a long list\n");
+        printf(" 29. test_list_sort - Test merge and counting sort\n");
+        printf(" 30. test_list_sort_loop - Test sorting a long random list\n");
+        printf(" 31. test_list_compact - Test compacting nodes into contiguous runs\n");
+        printf(" 32. test_list_compact_loop - Test compacting a long churned list\n");
+        printf(" 33. test_list_pools - Test lists with their own and shared pools\n");
+        printf(" 34. test_list_pools_loop - Test many lists with their own pools\n");
+        printf(" 35. test_list_for_each - Test visiting values one by one and in chunks\n");
+        printf(" 36. test_list_for_each_loop - Test visiting a long list in chunks\n");
+        printf(" 37. test_list_set_ops - Test merging, union, intersection and difference of sorted lists\n");
+        printf(" 38. test_list_set_ops_loop - Test sorted set operations on long random lists\n");
+        printf(" 39. test_list_index_duplicates - Test indexed inserts and removes of many repeated values\n");
+        printf(" 40. test_list_print_reverse - Test reverse printing against forward printing\n");
+        printf(" 41. test_list_create_twice - Test list_create while the default pool is in use\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -539,6 +2072,35 @@ int main(int argc, char *argv[])
         test_list_delete_loop(1000);
         test_list_search_loop(1000);
         test_list_edge_cases();
+
+        printf("\nTesting List handle:\n");
+        test_list_handle();
+        test_list_append_loop(100000);
+        test_list_index();
+        test_list_index_loop(50000);
+        test_list_doubly();
+        test_list_doubly_loop(100000);
+        test_list_from_array();
+        test_list_append_array_loop(100000);
+        test_list_delete_bulk();
+        test_list_delete_bulk_loop(100000);
+        test_list_format();
+        test_list_format_loop(200000);
+        test_list_save_load();
+        test_list_save_load_loop(200000);
+        test_list_sort();
+        test_list_sort_loop(200000);
+        test_list_compact();
+        test_list_compact_loop(100000);
+        test_list_pools();
+        test_list_pools_loop(100, 10000);
+        test_list_for_each();
+        test_list_for_each_loop(200000);
+        test_list_set_ops();
+        test_list_set_ops_loop(20000);
+        test_list_index_duplicates(100000);
+        test_list_print_reverse(10000);
+        test_list_create_twice();
         break;
     case 1:
         test_list_init();
@@ -583,6 +2145,87 @@ int main(int argc, char *argv[])
     case 14:
         test_list_edge_cases();
         break;
+    case 15:
+        test_list_handle();
+        break;
+    case 16:
+        test_list_append_loop(100000);
+        break;
+    case 17:
+        test_list_index();
+        break;
+    case 18:
+        test_list_index_loop(50000);
+        break;
+    case 19:
+        test_list_doubly();
+        break;
+    case 20:
+        test_list_doubly_loop(100000);
+        break;
+    case 21:
+        test_list_from_array();
+        break;
+    case 22:
+        test_list_append_array_loop(100000);
+        break;
+    case 23:
+        test_list_delete_bulk();
+        break;
+    case 24:
+        test_list_delete_bulk_loop(100000);
+        break;
+    case 25:
+        test_list_format();
+        break;
+    case 26:
+        test_list_format_loop(200000);
+        break;
+    case 27:
+        test_list_save_load();
+        break;
+    case 28:
+        test_list_save_load_loop(200000);
+        break;
+    case 29:
+        test_list_sort();
+        break;
+    case 30:
+        test_list_sort_loop(200000);
+        break;
+    case 31:
+        test_list_compact();
+        break;
+    case 32:
+        test_list_compact_loop(100000);
+        break;
+    case 33:
+        test_list_pools();
+        break;
+    case 34:
+        test_list_pools_loop(100, 10000);
+        break;
+    case 35:
+        test_list_for_each();
+        break;
+    case 36:
+        test_list_for_each_loop(200000);
+        break;
+    case 37:
+        test_list_set_ops();
+        break;
+    case 38:
+        test_list_set_ops_loop(20000);
+        break;
+    case 39:
+        test_list_index_duplicates(100000);
+        break;
+    case 40:
+        test_list_print_reverse(10000);
+        break;
+    case 41:
+        test_list_create_twice();
+        break;
 
     default:
         printf("Invalid test function\n");
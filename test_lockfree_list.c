@@ -0,0 +1,374 @@
+#include "lockfree_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Enough pool for the nodes of a test plus each thread's small-allocation
+// cache and the nodes awaiting reclamation.
+#define POOL_FOR(nodes, threads) \
+    (sizeof(LFNode) * 2 * (nodes) + (size_t)(threads) * 32 * (MEM_SMALL_CACHE_MAX + MEM_SMALL_REFILL + 4 * LFLIST_RETIRE_BATCH))
+
+// Function to capture the output of lflist_display.
+void capture_lflist_display(char *buffer, size_t size, LFList *list)
+{
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    stdout = fp;
+    lflist_display(list);
+    fflush(fp);
+    rewind(fp);
+
+    size_t length = fread(buffer, 1, size - 1, fp);
+    buffer[length] = '\0';
+
+    fclose(fp);
+    stdout = original_stdout;
+}
+
+static double elapsed_seconds(struct timespec *begin)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - begin->tv_sec) + (now.tv_nsec - begin->tv_nsec) / 1e9;
+}
+
+// ********* Test basic lock-free list operations *********
+
+void test_lflist_basic()
+{
+    printf_yellow(" Testing lflist insert, search and delete ---> ");
+    LFList list;
+    lflist_init(&list, POOL_FOR(16, 1));
+    LFThread *self = lflist_attach(&list);
+    my_assert(self != NULL);
+    char buffer[128];
+
+    capture_lflist_display(buffer, sizeof(buffer), &list);
+    my_assert(strcmp(buffer, "NULL") == 0);
+    my_assert(!lflist_search(self, 10) && !lflist_delete(self, 10));
+
+    lflist_insert(self, 30);
+    lflist_insert(self, 10);
+    lflist_enter(self);
+    LFNode *ten = lflist_find(self, 10);
+    my_assert(ten != NULL && ten->data == 10);
+    my_assert(lflist_insert_after(self, ten, 20) != NULL);
+    my_assert(lflist_insert_after(self, lflist_find(self, 30), 40) != NULL);
+    lflist_exit(self);
+    lflist_insert(self, 20);
+
+    capture_lflist_display(buffer, sizeof(buffer), &list);
+    my_assert(strcmp(buffer, "[20, 10, 20, 30, 40]") == 0);
+    my_assert(lflist_count_nodes(&list) == 5);
+
+    my_assert(lflist_delete(self, 20)); // The first of two
+    capture_lflist_display(buffer, sizeof(buffer), &list);
+    my_assert(strcmp(buffer, "[10, 20, 30, 40]") == 0);
+    my_assert(lflist_delete(self, 40)); // The last node
+    my_assert(lflist_delete(self, 10)); // The first node
+    my_assert(!lflist_delete(self, 99));
+    capture_lflist_display(buffer, sizeof(buffer), &list);
+    my_assert(strcmp(buffer, "[20, 30]") == 0);
+    my_assert(lflist_search(self, 30) && !lflist_search(self, 10));
+
+    lflist_detach(self);
+    lflist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_lflist_insert_after_deleted()
+{
+    printf_yellow(" Testing lflist_insert_after a deleted node ---> ");
+    LFList list;
+    lflist_init(&list, POOL_FOR(16, 1));
+    LFThread *self = lflist_attach(&list);
+    lflist_insert(self, 2);
+    lflist_insert(self, 1);
+
+    lflist_enter(self);
+    LFNode *one = lflist_find(self, 1);
+    my_assert(lflist_delete(self, 1));
+    // Still safe to touch inside the critical section, but deleted
+    my_assert(lflist_insert_after(self, one, 5) == NULL);
+    lflist_exit(self);
+    my_assert(!lflist_search(self, 5) && lflist_count_nodes(&list) == 1);
+
+    lflist_detach(self);
+    lflist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_lflist_attach_limit()
+{
+    printf_yellow(" Testing lflist_attach slots ---> ");
+    LFList list;
+    lflist_init(&list, POOL_FOR(1, 1));
+    LFThread *threads[LFLIST_MAX_THREADS];
+    for (int i = 0; i < LFLIST_MAX_THREADS; i++)
+    {
+        threads[i] = lflist_attach(&list);
+        my_assert(threads[i] != NULL);
+    }
+    my_assert(lflist_attach(&list) == NULL);
+    lflist_detach(threads[3]);
+    my_assert(lflist_attach(&list) == threads[3]);
+    for (int i = 0; i < LFLIST_MAX_THREADS; i++)
+    {
+        lflist_detach(threads[i]);
+    }
+    lflist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_lflist_reclamation(int rounds)
+{
+    printf_yellow(" Testing that deleted nodes return to the pool ---> ");
+    LFList list;
+    // Far fewer nodes than are ever inserted
+    lflist_init(&list, POOL_FOR(64, 1));
+    LFThread *self = lflist_attach(&list);
+    for (int i = 0; i < rounds; i++)
+    {
+        my_assert(lflist_insert(self, i) != NULL);
+        if (i >= 32)
+            my_assert(lflist_delete(self, i - 32));
+    }
+    my_assert(lflist_count_nodes(&list) == 32);
+    my_assert(list.epoch > 1);
+
+    lflist_detach(self);
+    lflist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* Concurrency *********
+
+typedef struct StressArgs
+{
+    LFList *list;
+    int id;
+    int count;
+    unsigned long long ops;
+} StressArgs;
+
+// Inserts its own values, deletes every other one, and checks what it sees.
+static void *stress_writer(void *arg)
+{
+    StressArgs *args = arg;
+    LFThread *self = lflist_attach(args->list);
+    my_assert(self != NULL);
+    uint16_t base = (uint16_t)(args->id * args->count);
+    for (int round = 0; round < 4; round++)
+    {
+        for (int i = 0; i < args->count; i++)
+        {
+            my_assert(lflist_insert(self, base + i) != NULL);
+        }
+        for (int i = 0; i < args->count; i++)
+        {
+            my_assert(lflist_search(self, base + i));
+        }
+        // Leave the odd values of the last round
+        for (int i = 0; i < args->count; i += (round == 3) ? 2 : 1)
+        {
+            my_assert(lflist_delete(self, base + i));
+        }
+    }
+    lflist_detach(self);
+    return NULL;
+}
+
+// Searches while writers run, inserting after the nodes it finds.
+static void *stress_reader(void *arg)
+{
+    StressArgs *args = arg;
+    LFThread *self = lflist_attach(args->list);
+    my_assert(self != NULL);
+    for (int i = 0; i < args->count; i++)
+    {
+        lflist_enter(self);
+        LFNode *node = lflist_find(self, (uint16_t)(i % 1024));
+        if (node != NULL && i % 8 == 0)
+        {
+            my_assert(node->data == (uint16_t)(i % 1024)); // Never a freed node
+            LFNode *added = lflist_insert_after(self, node, 65000);
+            if (added)
+                lflist_delete(self, 65000);
+        }
+        lflist_exit(self);
+    }
+    lflist_detach(self);
+    return NULL;
+}
+
+void test_lflist_stress(int writers, int readers, int count)
+{
+    printf_yellow(" Testing %d writers and %d readers concurrently ---> ", writers, readers);
+    LFList list;
+    // Room for every node ever inserted: a thread preempted in a critical
+    // section holds reclamation back for everyone, which on a loaded machine
+    // can last a while
+    lflist_init(&list, POOL_FOR(writers * count * 4 + readers * count * 20 / 8, writers + readers));
+    pthread_t threads[writers + readers];
+    StressArgs args[writers + readers];
+    for (int i = 0; i < writers + readers; i++)
+    {
+        args[i] = (StressArgs){&list, i, i < writers ? count : 20 * count, 0};
+        my_assert(pthread_create(&threads[i], NULL, i < writers ? stress_writer : stress_reader, &args[i]) == 0);
+    }
+    for (int i = 0; i < writers + readers; i++)
+    {
+        my_assert(pthread_join(threads[i], NULL) == 0);
+    }
+
+    my_assert(lflist_count_nodes(&list) == (size_t)(writers * (count / 2)));
+    LFThread *self = lflist_attach(&list);
+    for (int w = 0; w < writers; w++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            my_assert(lflist_search(self, (uint16_t)(w * count + i)) == (i % 2 == 1));
+        }
+    }
+    lflist_detach(self);
+    lflist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Mixed workload: mostly searches, some inserts and deletes of a key range.
+static void *throughput_worker(void *arg)
+{
+    StressArgs *args = arg;
+    LFThread *self = lflist_attach(args->list);
+    unsigned seed = args->id * 7919 + 1;
+    for (int i = 0; i < args->count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint16_t value = (seed >> 16) % 256;
+        unsigned kind = (seed >> 8) % 10;
+        if (kind == 0 && !lflist_search(self, value)) // Keep the list about the same length
+            lflist_insert(self, value);
+        else if (kind == 1)
+            lflist_delete(self, value);
+        else
+            lflist_search(self, value);
+    }
+    args->ops = args->count;
+    lflist_detach(self);
+    return NULL;
+}
+
+void test_lflist_throughput(int count)
+{
+    printf_yellow(" Testing lock-free list throughput:\n");
+    for (int threadCount = 1; threadCount <= 8; threadCount *= 2)
+    {
+        LFList list;
+        lflist_init(&list, POOL_FOR(4096, threadCount));
+        LFThread *self = lflist_attach(&list);
+        for (int i = 0; i < 128; i++)
+        {
+            lflist_insert(self, i * 2);
+        }
+        lflist_detach(self);
+
+        pthread_t threads[threadCount];
+        StressArgs args[threadCount];
+        struct timespec begin;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (int i = 0; i < threadCount; i++)
+        {
+            args[i] = (StressArgs){&list, i, count, 0};
+            my_assert(pthread_create(&threads[i], NULL, throughput_worker, &args[i]) == 0);
+        }
+        unsigned long long ops = 0;
+        for (int i = 0; i < threadCount; i++)
+        {
+            my_assert(pthread_join(threads[i], NULL) == 0);
+            ops += args[i].ops;
+        }
+        double seconds = elapsed_seconds(&begin);
+        printf("   %d thread(s): %.2f Mops/s\n", threadCount, ops / seconds / 1e6);
+        lflist_cleanup(&list);
+    }
+    printf_green("  [PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+  srand(time(NULL));
+#ifdef VERSION
+  printf("Build Version; %s \n", VERSION);
+#endif
+  printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_lflist_basic - Test insert, search and delete\n");
+        printf(" 2. test_lflist_insert_after_deleted - Test that inserting after a deleted node fails\n");
+        printf(" 3. test_lflist_attach_limit - Test attaching and detaching threads\n");
+        printf(" 4. test_lflist_reclamation - Test that deleted nodes return to the pool\n");
+
+        printf("\nConcurrency:\n");
+        printf(" 5. test_lflist_stress - Test concurrent writers and readers\n");
+        printf(" 6. test_lflist_throughput - Measure throughput with 1 to 8 threads\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_lflist_basic();
+        test_lflist_insert_after_deleted();
+        test_lflist_attach_limit();
+        test_lflist_reclamation(100000);
+
+        printf("\nTesting Concurrency:\n");
+        test_lflist_stress(4, 4, 500);
+        test_lflist_throughput(50000);
+        break;
+    case 1:
+        test_lflist_basic();
+        break;
+    case 2:
+        test_lflist_insert_after_deleted();
+        break;
+    case 3:
+        test_lflist_attach_limit();
+        break;
+    case 4:
+        test_lflist_reclamation(100000);
+        break;
+    case 5:
+        test_lflist_stress(4, 4, 500);
+        break;
+    case 6:
+        test_lflist_throughput(50000);
+        break;
+
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -3,7 +3,11 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pthread.h>
 #include "common_defs.h"
 
 #include "gitdata.h"
@@ -322,6 +326,420 @@ void test_edge_case_allocations()
     printf_green("[PASS].\n");
 }
 
+void test_huge_alloc()
+{
+    printf_yellow(" Testing directly mapped huge allocations ---> ");
+    mem_set_huge_threshold(64 * 1024);
+    mem_init(1024);
+
+    size_t hugeSize = 1024 * 1024;
+    unsigned char *huge = mem_alloc(hugeSize); // Larger than the pool, mapped on its own
+    my_assert(huge != NULL);
+    memset(huge, 0xAB, hugeSize);
+
+    void *small = mem_alloc(1024); // The pool is still untouched
+    my_assert(small != NULL);
+    mem_free(small);
+
+    huge = mem_resize(huge, 4 * hugeSize); // Grows through mremap
+    my_assert(huge != NULL);
+    my_assert(huge[0] == 0xAB && huge[hugeSize - 1] == 0xAB);
+    huge[4 * hugeSize - 1] = 0xCD;
+
+    unsigned char *shrunk = mem_resize(huge, 100); // Back into the pool
+    my_assert(shrunk != NULL);
+    my_assert(shrunk[0] == 0xAB && shrunk[99] == 0xAB);
+    void *rest = mem_alloc(1024 - 100);
+    my_assert(rest != NULL);
+    mem_free(rest);
+
+    void *grown = mem_resize(shrunk, 128 * 1024); // Out of the pool again
+    my_assert(grown != NULL);
+    my_assert(((unsigned char *)grown)[99] == 0xAB);
+    my_assert(mem_alloc(1024) != NULL);
+
+    mem_free(grown);
+    mem_deinit();
+    mem_set_huge_threshold(MEM_HUGE_THRESHOLD);
+    printf_green("[PASS].\n");
+}
+
+void test_file_backed_pool()
+{
+    printf_yellow(" Testing file-backed pool reopen ---> ");
+    char path[] = "/tmp/test_memory_manager_XXXXXX";
+    int fd = mkstemp(path);
+    my_assert(fd >= 0);
+    close(fd);
+    unlink(path); // mem_init_file creates the pool in an empty file
+
+    // Build a small chain of blocks linked by offsets
+    my_assert(mem_init_file(path, 4096));
+    size_t *first = mem_alloc(2 * sizeof(size_t));
+    size_t *second = mem_alloc(2 * sizeof(size_t));
+    my_assert(first != NULL && second != NULL);
+    first[0] = 111;
+    first[1] = mem_offset(second);
+    second[0] = 222;
+    second[1] = MEM_NULL_OFFSET;
+    mem_set_root(first);
+    my_assert(mem_checkpoint());
+    mem_deinit();
+
+    // Reopen; the size argument is ignored for an existing pool
+    my_assert(mem_init_file(path, 1));
+    first = mem_get_root();
+    my_assert(first != NULL && first[0] == 111);
+    second = mem_pointer(first[1]);
+    my_assert(second != NULL && second[0] == 222);
+    my_assert(mem_pointer(second[1]) == NULL);
+
+    void *block = mem_alloc(100); // Must not overlap the persisted blocks
+    my_assert(block != NULL && block != first && block != second);
+    my_assert(mem_alloc(4096) == NULL);
+    mem_free(block);
+    mem_free(second);
+    my_assert(mem_sync());
+    mem_deinit();
+
+    unlink(path);
+    printf_green("[PASS].\n");
+}
+
+void test_shared_pool()
+{
+    printf_yellow(" Testing shared pool across processes ---> ");
+    enum { WORKERS = 4, BLOCKS = 50 };
+    char name[64];
+    sprintf(name, "/test_memory_manager_%d", (int)getpid());
+    mem_unlink_shared(name);
+
+    my_assert(mem_init_shared(name, 64 * 1024));
+    size_t *table = mem_alloc(WORKERS * BLOCKS * sizeof(size_t)); // Offsets of every worker's blocks
+    my_assert(table != NULL);
+    mem_set_root(table);
+
+    pid_t pids[WORKERS];
+    for (int w = 0; w < WORKERS; w++)
+    {
+        pids[w] = fork();
+        my_assert(pids[w] >= 0);
+        if (pids[w] == 0)
+        {
+            // Drop the inherited mapping and attach again, at whatever address it lands
+            mem_deinit();
+            my_assert(mem_init_shared(name, 0));
+            size_t *shared = mem_get_root();
+            for (int k = 0; k < BLOCKS; k++)
+            {
+                int *block = mem_alloc(2 * sizeof(int));
+                my_assert(block != NULL);
+                block[0] = w;
+                block[1] = k;
+                shared[w * BLOCKS + k] = mem_offset(block);
+            }
+            mem_deinit();
+            _exit(0);
+        }
+    }
+
+    for (int w = 0; w < WORKERS; w++)
+    {
+        int status;
+        my_assert(waitpid(pids[w], &status, 0) == pids[w]);
+        my_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    // Overlapping blocks would have overwritten each other's contents
+    for (int w = 0; w < WORKERS; w++)
+    {
+        for (int k = 0; k < BLOCKS; k++)
+        {
+            int *block = mem_pointer(table[w * BLOCKS + k]);
+            my_assert(block != NULL);
+            my_assert(block[0] == w && block[1] == k);
+            mem_free(block);
+        }
+    }
+
+    mem_free(table);
+    mem_deinit();
+    my_assert(mem_unlink_shared(name));
+    printf_green("[PASS].\n");
+}
+
+void test_scavenger()
+{
+    printf_yellow(" Testing background scavenger ---> ");
+    size_t poolSize = 1024 * 1024;
+    mem_init(poolSize);
+
+    unsigned char *keep = mem_alloc(1000);
+    unsigned char *big = mem_alloc(512 * 1024);
+    my_assert(keep != NULL && big != NULL);
+    memset(keep, 0x5A, 1000);
+    memset(big, 0x33, 512 * 1024);
+    unsigned char *tail = mem_alloc(400 * 1024); // Spans several scavenger slices
+    my_assert(tail != NULL);
+    memset(tail, 0x77, 400 * 1024);
+    mem_free(big); // Leaves whole pages free for the scavenger to decommit
+
+    my_assert(mem_scavenger_start(1, 50));
+    my_assert(!mem_scavenger_start(1, 50)); // Only one scavenger at a time
+
+    MemScavengerStats stats = {0};
+    for (int i = 0; i < 2000 && (stats.passes < MEM_SCAVENGE_IDLE_PASSES + 2); i++)
+    {
+        usleep(1000);
+        mem_scavenger_stats(&stats);
+    }
+    my_assert(stats.passes >= MEM_SCAVENGE_IDLE_PASSES + 2);
+    my_assert(stats.decommittedPages > 0);
+
+    // Allocations keep working while the scavenger runs
+    my_assert(mem_alloc(600 * 1024) == NULL); // No run that long is left
+    void *reuse = mem_alloc(256 * 1024);
+    my_assert(reuse == big);
+    memset(reuse, 0x11, 256 * 1024);
+    for (int i = 0; i < 1000; i++)
+    {
+        my_assert(keep[i] == 0x5A);
+    }
+
+    // Later passes must not decommit pages of the blocks allocated meanwhile
+    size_t passes = stats.passes;
+    for (int i = 0; i < 2000 && stats.passes < passes + MEM_SCAVENGE_IDLE_PASSES + 2; i++)
+    {
+        usleep(1000);
+        mem_scavenger_stats(&stats);
+    }
+    my_assert(stats.passes >= passes + MEM_SCAVENGE_IDLE_PASSES + 2);
+    for (size_t i = 0; i < 256 * 1024; i++)
+    {
+        my_assert(((unsigned char *)reuse)[i] == 0x11 && tail[i] == 0x77);
+    }
+
+    mem_scavenger_stop();
+    mem_free(reuse);
+    mem_free(tail);
+    mem_free(keep);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void *small_alloc_worker(void *arg)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        void *block = mem_alloc_small(24);
+        my_assert(block != NULL);
+        mem_free_small(block, 24);
+    }
+    return arg; // The thread's cache is flushed when it exits
+}
+
+void *small_free_worker(void *arg)
+{
+    void **blocks = arg;
+    for (int i = 0; i < 16; i++)
+    {
+        mem_free_small(blocks[i], 16); // Only frees, into a cache it never filled
+    }
+    return NULL;
+}
+
+void test_small_alloc()
+{
+    printf_yellow(" Testing small allocation fast path ---> ");
+    size_t poolSize = 16 * 1024;
+    mem_init(poolSize);
+
+    enum { COUNT = 128 };
+    unsigned char *blocks[COUNT];
+    for (int i = 0; i < COUNT; i++)
+    {
+        size_t size = 1 + i % (MEM_SMALL_CLASSES * MEM_SMALL_GRANULE);
+        blocks[i] = mem_alloc_small(size);
+        my_assert(blocks[i] != NULL);
+        memset(blocks[i], i, size);
+    }
+    for (int i = 0; i < COUNT; i++) // No block was handed out twice
+    {
+        size_t size = 1 + i % (MEM_SMALL_CLASSES * MEM_SMALL_GRANULE);
+        for (size_t k = 0; k < size; k++)
+        {
+            my_assert(blocks[i][k] == (unsigned char)i);
+        }
+    }
+
+    mem_free_small(blocks[5], 6);
+    my_assert(mem_alloc_small(1) == blocks[5]); // Same size class, served from the cache
+    mem_free(blocks[5]);                        // Small blocks are ordinary pool blocks
+    for (int i = 0; i < COUNT; i++)
+    {
+        if (i != 5)
+            mem_free_small(blocks[i], 1 + i % (MEM_SMALL_CLASSES * MEM_SMALL_GRANULE));
+    }
+
+    my_assert(mem_alloc(poolSize) == NULL); // The cache still holds blocks
+    mem_small_flush();
+    void *whole = mem_alloc(poolSize);
+    my_assert(whole != NULL);
+    mem_free(whole);
+
+    pthread_t thread;
+    my_assert(pthread_create(&thread, NULL, small_alloc_worker, NULL) == 0);
+    my_assert(pthread_join(thread, NULL) == 0);
+    whole = mem_alloc(poolSize);
+    my_assert(whole != NULL);
+    mem_free(whole);
+
+    // Blocks freed by a thread that never allocated are drained at its exit too
+    void *handed[16];
+    for (int i = 0; i < 16; i++)
+    {
+        handed[i] = mem_alloc_small(16);
+        my_assert(handed[i] != NULL);
+    }
+    mem_small_flush();
+    my_assert(pthread_create(&thread, NULL, small_free_worker, handed) == 0);
+    my_assert(pthread_join(thread, NULL) == 0);
+    whole = mem_alloc(poolSize);
+    my_assert(whole != NULL);
+    mem_free(whole);
+
+    // Cached blocks from an old pool are never handed out
+    void *stale = mem_alloc_small(16);
+    mem_free_small(stale, 16);
+    mem_deinit();
+    mem_init(poolSize);
+    void *fresh = mem_alloc_small(16);
+    my_assert(fresh != NULL);
+    mem_free_small(fresh, 16);
+    mem_small_flush();
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_alloc_batch()
+{
+    printf_yellow(" Testing batch allocation of adjacent blocks ---> ");
+    size_t poolSize = 1024;
+    mem_init(poolSize);
+
+    my_assert(mem_alloc_batch(0, 4) == NULL);
+    my_assert(mem_alloc_batch(16, 0) == NULL);
+    my_assert(mem_alloc_batch(SIZE_MAX / 2, 4) == NULL); // size * count overflows
+
+    char *head = mem_alloc(10);
+    char *batch = mem_alloc_batch(24, 10);
+    my_assert(batch == head + 10);
+    char *after = mem_alloc(8);
+    my_assert(after == batch + 240);
+
+    // Every block of the batch is freed on its own
+    mem_free(batch + 24 * 3);
+    my_assert(mem_alloc(24) == batch + 24 * 3);
+    mem_free(batch + 24 * 3);
+    void *wider = mem_alloc(25);
+    my_assert(wider != batch + 24 * 3); // Block 4 is still in use
+    mem_free(wider);
+    for (int i = 0; i < 10; i++)
+    {
+        mem_free(batch + 24 * i);
+    }
+    my_assert(mem_alloc_batch(24, 10) == batch);
+
+    // A batch needs one free run, not just enough free bytes
+    for (int i = 0; i < 10; i++)
+    {
+        mem_free(batch + 24 * i);
+    }
+    my_assert(mem_alloc_batch(100, 9) == NULL);
+    my_assert(mem_alloc_batch(100, 7) == after + 8);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_free_batch()
+{
+    printf_yellow(" Testing batch free ---> ");
+    size_t poolSize = 1024;
+    mem_init(poolSize);
+
+    void *blocks[8];
+    for (int i = 0; i < 8; i++)
+    {
+        blocks[i] = mem_alloc(poolSize / 8);
+        my_assert(blocks[i] != NULL);
+    }
+    my_assert(mem_alloc(1) == NULL);
+
+    // NULL entries are skipped, and freed blocks can be reused at once
+    void *odd[] = {blocks[1], NULL, blocks[3], blocks[5], blocks[7]};
+    mem_free_batch(odd, 5);
+    my_assert(mem_alloc(poolSize / 8) == blocks[1]);
+    mem_free_batch(NULL, 0);
+
+    void *rest[] = {blocks[0], blocks[1], blocks[2], blocks[4], blocks[6]};
+    mem_free_batch(rest, 5);
+    void *whole = mem_alloc(poolSize);
+    my_assert(whole == blocks[0]);
+    mem_free(whole);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_pool_create()
+{
+    printf_yellow(" Testing independent pools ---> ");
+    size_t poolSize = 1024;
+    mem_init(poolSize);
+    MemPool *a = mem_pool_create(poolSize);
+    MemPool *b = mem_pool_create(poolSize / 2);
+    my_assert(a != NULL && b != NULL);
+
+    // Every pool has all of its room, whatever the others hold
+    void *inDefault = mem_alloc(poolSize / 2);
+    mem_set_huge_threshold(256); // Only the default pool maps blocks directly
+    void *inA = mem_pool_alloc(a, poolSize);
+    void *inB = mem_pool_alloc(b, poolSize / 2);
+    my_assert(inDefault != NULL && inA != NULL && inB != NULL);
+    my_assert((uintptr_t)inA % 16 == 0 && (uintptr_t)inB % 16 == 0);
+    my_assert(mem_pool_alloc(a, 1) == NULL && mem_pool_alloc(b, 1) == NULL);
+    memset(inA, 0xAA, poolSize);
+    memset(inB, 0xBB, poolSize / 2);
+    mem_pool_free(a, inA);
+    my_assert(mem_pool_alloc(a, poolSize) == inA);
+    my_assert(((unsigned char *)inB)[0] == 0xBB && ((unsigned char *)inB)[poolSize / 2 - 1] == 0xBB);
+    mem_set_huge_threshold(MEM_HUGE_THRESHOLD);
+
+    // NULL is the default pool
+    my_assert(mem_pool_alloc(NULL, poolSize / 2) != NULL && mem_alloc(1) == NULL);
+    mem_pool_free(NULL, inDefault);
+    my_assert(mem_alloc(poolSize / 2) == inDefault);
+
+    // Batches and resizing stay within the pool
+    mem_pool_free(b, inB);
+    char *batch = mem_pool_alloc_batch(b, 64, 8);
+    my_assert(batch != NULL && mem_pool_alloc(b, 1) == NULL);
+    void *halves[] = {batch, batch + 64, batch + 128, batch + 192};
+    mem_pool_free_batch(b, halves, 4);
+    char *grown = mem_pool_resize(b, batch + 448, 256);
+    my_assert(grown == batch);
+    my_assert(mem_pool_resize(b, grown, 512) == NULL);
+
+    // Destroying a pool releases its blocks and nothing else
+    mem_pool_destroy(a);
+    mem_pool_destroy(b);
+    mem_pool_destroy(NULL);
+    my_assert(mem_alloc(1) == NULL);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef VERSION
@@ -354,6 +772,14 @@ int main(int argc, char *argv[])
         printf(" 14. test_block_merging - Test merging of adjacent free blocks\n");
         printf(" 15. test_non_contiguous_allocation_failure - Ensure failure when no contiguous block fits\n");
         printf(" 16. test_contiguous_allocation_success - Ensure success when a contiguous block fits\n");
+        printf(" 19. test_huge_alloc - Test directly mapped huge allocations\n");
+        printf(" 20. test_file_backed_pool - Test reopening a file-backed pool\n");
+        printf(" 21. test_shared_pool - Test a pool shared by several processes\n");
+        printf(" 22. test_scavenger - Test the background scavenger thread\n");
+        printf(" 23. test_small_alloc - Test the per-thread small allocation cache\n");
+        printf(" 24. test_alloc_batch - Test batch allocation of adjacent blocks\n");
+        printf(" 25. test_free_batch - Test freeing several blocks at once\n");
+        printf(" 26. test_pool_create - Test independent pools\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -390,6 +816,14 @@ int main(int argc, char *argv[])
         printf("\nVarious other tests:\n");
         test_zero_alloc_and_free();
         test_random_blocks();
+        test_huge_alloc();
+        test_file_backed_pool();
+        test_shared_pool();
+        test_scavenger();
+        test_small_alloc();
+        test_alloc_batch();
+        test_free_batch();
+        test_pool_create();
         break;
     case 1:
         test_init();
@@ -445,6 +879,30 @@ int main(int argc, char *argv[])
     case 18:
         test_random_blocks();
         break;
+    case 19:
+        test_huge_alloc();
+        break;
+    case 20:
+        test_file_backed_pool();
+        break;
+    case 21:
+        test_shared_pool();
+        break;
+    case 22:
+        test_scavenger();
+        break;
+    case 23:
+        test_small_alloc();
+        break;
+    case 24:
+        test_alloc_batch();
+        break;
+    case 25:
+        test_free_batch();
+        break;
+    case 26:
+        test_pool_create();
+        break;
     default:
         printf("Invalid test function\n");
         break;
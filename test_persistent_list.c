@@ -0,0 +1,356 @@
+#include "persistent_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Function to capture the output of plist_display.
+void capture_plist_display(char *buffer, size_t size, const PSnapshot *snapshot)
+{
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    stdout = fp;
+    plist_display(snapshot);
+    fflush(fp);
+    rewind(fp);
+
+    size_t length = fread(buffer, 1, size - 1, fp);
+    buffer[length] = '\0';
+
+    fclose(fp);
+    stdout = original_stdout;
+}
+
+// Checks the values of a snapshot and that its count matches them.
+void assert_snapshot_equals(const PSnapshot *snapshot, const uint16_t *expected, size_t count)
+{
+    const PNode *current = snapshot->head;
+    for (size_t i = 0; i < count; i++)
+    {
+        my_assert(current != NULL && current->data == expected[i]);
+        current = current->next;
+    }
+    my_assert(current == NULL && snapshot->count == count);
+}
+
+// Checks that the whole pool is free again, once cached blocks are returned.
+void assert_pool_free(size_t size)
+{
+    mem_small_flush();
+    void *all = mem_alloc(size);
+    my_assert(all != NULL);
+    mem_free(all);
+}
+
+// ********* Test basic persistent list operations *********
+
+void test_plist_basic()
+{
+    printf_yellow(" Testing plist prepend, insert, insert_at and delete ---> ");
+    PList list;
+    plist_init(&list, 4096);
+    char buffer[64];
+
+    PSnapshot snapshot = plist_snapshot(&list);
+    capture_plist_display(buffer, sizeof(buffer), &snapshot);
+    my_assert(strcmp(buffer, "NULL") == 0 && plist_search(&snapshot, 1) == NULL);
+    plist_release(&snapshot);
+    my_assert(!plist_delete(&list, 1) && !plist_insert_at(&list, 1, 1));
+
+    my_assert(plist_insert(&list, 3) && plist_prepend(&list, 1) && plist_insert(&list, 5));
+    my_assert(plist_insert_at(&list, 1, 2) && plist_insert_at(&list, 3, 4) && plist_insert_at(&list, 5, 6));
+    my_assert(!plist_insert_at(&list, 7, 7) && plist_count(&list) == 6);
+    snapshot = plist_snapshot(&list);
+    uint16_t expected[] = {1, 2, 3, 4, 5, 6};
+    assert_snapshot_equals(&snapshot, expected, 6);
+    capture_plist_display(buffer, sizeof(buffer), &snapshot);
+    my_assert(strcmp(buffer, "[1, 2, 3, 4, 5, 6]") == 0);
+    my_assert(plist_search(&snapshot, 4)->data == 4 && plist_search(&snapshot, 7) == NULL);
+    plist_release(&snapshot);
+    my_assert(snapshot.head == NULL && snapshot.count == 0);
+
+    // Head, middle and tail
+    my_assert(plist_delete(&list, 1) && plist_delete(&list, 4) && plist_delete(&list, 6));
+    my_assert(!plist_delete(&list, 4) && plist_count(&list) == 3);
+    snapshot = plist_snapshot(&list);
+    uint16_t afterDelete[] = {2, 3, 5};
+    assert_snapshot_equals(&snapshot, afterDelete, 3);
+    plist_release(&snapshot);
+
+    while (list.current.head != NULL)
+    {
+        my_assert(plist_delete(&list, list.current.head->data));
+    }
+    assert_pool_free(4096);
+    plist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_plist_snapshots()
+{
+    printf_yellow(" Testing plist snapshots and structural sharing ---> ");
+    PList list;
+    plist_init(&list, 4096);
+    for (int i = 5; i >= 1; i--)
+    {
+        my_assert(plist_prepend(&list, (uint16_t)i));
+    }
+    PSnapshot before = plist_snapshot(&list);
+    uint16_t values[] = {1, 2, 3, 4, 5};
+    my_assert(before.head == list.current.head && before.head->refs == 2);
+
+    // Prepending shares every node
+    my_assert(plist_prepend(&list, 0));
+    my_assert(list.current.head->next == before.head);
+
+    // Deleting copies only the nodes in front of the deleted one
+    const PNode *four = plist_search(&before, 4);
+    my_assert(plist_delete(&list, 3));
+    PSnapshot after = plist_snapshot(&list);
+    uint16_t afterValues[] = {0, 1, 2, 4, 5};
+    assert_snapshot_equals(&after, afterValues, 5);
+    my_assert(plist_search(&after, 4) == four && four->refs == 2);
+    my_assert(plist_search(&after, 1) != plist_search(&before, 1));
+
+    // The old version is unchanged and both can be read after the list moves on
+    my_assert(plist_insert(&list, 9) && plist_delete(&list, 0));
+    assert_snapshot_equals(&before, values, 5);
+    assert_snapshot_equals(&after, afterValues, 5);
+
+    // Releasing a snapshot frees the nodes only it held
+    plist_release(&before);
+    my_assert(four->refs == 1);
+    plist_release(&after);
+    PSnapshot last = plist_snapshot(&list);
+    uint16_t lastValues[] = {1, 2, 4, 5, 9};
+    assert_snapshot_equals(&last, lastValues, 5);
+    for (const PNode *node = last.head; node != NULL; node = node->next)
+    {
+        my_assert(node->refs == (node == last.head ? 2u : 1u));
+    }
+    plist_release(&last);
+
+    for (int i = 0; i < 5; i++)
+    {
+        my_assert(plist_delete(&list, lastValues[i]));
+    }
+    assert_pool_free(4096);
+    plist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_plist_shared_pool()
+{
+    printf_yellow(" Testing plists on an already initialized pool ---> ");
+    mem_init(4096);
+    char *block = (char *)mem_alloc(64);
+    my_assert(block != NULL);
+    memset(block, 0x5a, 64);
+
+    // Neither list re-initializes the pool, nor releases it on cleanup
+    PList first, second;
+    plist_init(&first, 4096);
+    plist_init(&second, 4096);
+    my_assert(plist_insert(&first, 1) && plist_insert(&second, 2) && plist_insert(&first, 3));
+    PSnapshot snapshot = plist_snapshot(&first);
+    uint16_t expected[] = {1, 3};
+    assert_snapshot_equals(&snapshot, expected, 2);
+    plist_release(&snapshot);
+    plist_cleanup(&second);
+    plist_cleanup(&first);
+
+    my_assert(mem_initialized());
+    for (int i = 0; i < 64; i++)
+    {
+        my_assert(block[i] == 0x5a);
+    }
+    mem_free(block);
+    mem_deinit();
+    my_assert(!mem_initialized());
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_plist_snapshot_loop(int count)
+{
+    printf_yellow(" Testing many snapshots of a changing list ---> ");
+    size_t poolSize = sizeof(PNode) * count * 4;
+    PList list;
+    plist_init(&list, poolSize);
+    PSnapshot snapshots[16];
+    int taken = 0;
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t value = (uint16_t)(rand() % 64);
+        if (rand() % 4 == 0)
+            plist_delete(&list, value);
+        else
+            my_assert(plist_prepend(&list, value));
+
+        if (i % 64 == 0)
+        {
+            // Keep up to 16 old versions alive, releasing the oldest
+            if (taken == 16)
+            {
+                plist_release(&snapshots[0]);
+                memmove(snapshots, snapshots + 1, 15 * sizeof(PSnapshot));
+                taken--;
+            }
+            snapshots[taken++] = plist_snapshot(&list);
+        }
+    }
+    for (int i = 0; i < taken; i++)
+    {
+        size_t length = 0;
+        for (const PNode *node = snapshots[i].head; node != NULL; node = node->next)
+            length++;
+        my_assert(length == snapshots[i].count);
+        plist_release(&snapshots[i]);
+    }
+    while (list.current.head != NULL)
+    {
+        my_assert(plist_delete(&list, list.current.head->data));
+    }
+    assert_pool_free(poolSize);
+    plist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+typedef struct ScanArgs
+{
+    PList *list;
+    int count;
+    volatile bool *stop;
+    unsigned long long scans;
+} ScanArgs;
+
+// Keeps taking snapshots and checks that each is a consistent version: the
+// writer only ever holds the values 0 to n - 1 in order for some n.
+static void *snapshot_reader(void *arg)
+{
+    ScanArgs *args = arg;
+    while (!__atomic_load_n(args->stop, __ATOMIC_ACQUIRE))
+    {
+        PSnapshot snapshot = plist_snapshot(args->list);
+        size_t length = 0;
+        for (const PNode *node = snapshot.head; node != NULL; node = node->next)
+        {
+            my_assert(node->data == length);
+            length++;
+        }
+        my_assert(length == snapshot.count);
+        plist_release(&snapshot);
+        args->scans++;
+    }
+    return NULL;
+}
+
+void test_plist_concurrent(int readers, int count)
+{
+    printf_yellow(" Testing a writer with %d snapshot readers ---> ", readers);
+    size_t poolSize = sizeof(PNode) * 64 * 1024 + (size_t)(readers + 1) * MEM_SMALL_GRANULE * MEM_SMALL_CACHE_MAX * 2;
+    PList list;
+    plist_init(&list, poolSize);
+    volatile bool stop = false;
+    pthread_t threads[readers];
+    ScanArgs args[readers];
+    for (int i = 0; i < readers; i++)
+    {
+        args[i] = (ScanArgs){&list, count, &stop, 0};
+        my_assert(pthread_create(&threads[i], NULL, snapshot_reader, &args[i]) == 0);
+    }
+
+    // Grow to 256 values at the end and shrink from the end, over and over
+    for (int round = 0; round < count; round++)
+    {
+        for (int i = 0; i < 256; i++)
+            my_assert(plist_insert(&list, (uint16_t)i));
+        for (int i = 255; i >= 0; i--)
+            my_assert(plist_delete(&list, (uint16_t)i));
+    }
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < readers; i++)
+    {
+        my_assert(pthread_join(threads[i], NULL) == 0);
+        my_assert(args[i].scans > 0);
+    }
+
+    my_assert(plist_count(&list) == 0);
+    assert_pool_free(poolSize);
+    plist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+  srand(time(NULL));
+#ifdef VERSION
+  printf("Build Version; %s \n", VERSION);
+#endif
+  printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_plist_basic - Test prepend, insert, insert_at and delete\n");
+        printf(" 2. test_plist_snapshots - Test snapshots and structural sharing\n");
+        printf(" 3. test_plist_shared_pool - Test lists on an already initialized pool\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 4. test_plist_snapshot_loop - Test many snapshots of a changing list\n");
+        printf(" 5. test_plist_concurrent - Test snapshot readers next to a writer\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+      printf("No tests will be executed.\n");
+      break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_plist_basic();
+        test_plist_snapshots();
+        test_plist_shared_pool();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_plist_snapshot_loop(20000);
+        test_plist_concurrent(4, 50);
+        break;
+    case 1:
+        test_plist_basic();
+        break;
+    case 2:
+        test_plist_snapshots();
+        break;
+    case 3:
+        test_plist_shared_pool();
+        break;
+    case 4:
+        test_plist_snapshot_loop(20000);
+        break;
+    case 5:
+        test_plist_concurrent(4, 50);
+        break;
+
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
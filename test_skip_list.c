@@ -0,0 +1,358 @@
+#include "skip_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Function to capture the output of a skip list display function.
+void capture_slist_display(char *buffer, size_t size, void (*func)(SList *, SNode *, SNode *), SList *list, SNode *start_node, SNode *end_node)
+{
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    stdout = fp;
+    func(list, start_node, end_node);
+    fflush(fp);
+    rewind(fp);
+
+    size_t length = fread(buffer, 1, size - 1, fp);
+    buffer[length] = '\0';
+
+    fclose(fp);
+    stdout = original_stdout;
+}
+
+// Adapts slist_display_values to capture_slist_display, taking the bounds from
+// the data of the two nodes.
+static uint16_t display_low, display_high;
+void display_values(SList *list, SNode *start_node, SNode *end_node)
+{
+    (void)start_node;
+    (void)end_node;
+    slist_display_values(list, display_low, display_high);
+}
+
+// Checks that every level is sorted and only skips over nodes of lower
+// height, and that level 0 holds count nodes.
+void assert_slist_valid(SList *list)
+{
+    for (int level = 0; level < SLIST_MAX_LEVEL; level++)
+    {
+        SNode *below = list->head->next[0];
+        for (SNode *node = list->head->next[level]; node != NULL; node = node->next[level])
+        {
+            my_assert(node->height > level);
+            my_assert(node->next[level] == NULL || node->next[level]->data >= node->data);
+            while (below != node)
+            {
+                my_assert(below != NULL && below->height <= level);
+                below = below->next[0];
+            }
+            below = below->next[0];
+        }
+        if (level >= list->level)
+        {
+            my_assert(list->head->next[level] == NULL);
+        }
+    }
+
+    size_t count = 0;
+    for (SNode *node = list->head->next[0]; node != NULL; node = node->next[0])
+    {
+        count++;
+    }
+    my_assert(count == slist_count(list));
+}
+
+// ********* Test basic skip list operations *********
+
+void test_slist_init()
+{
+    printf_yellow(" Testing slist_init ---> ");
+    SList list;
+    slist_init(&list, 1024);
+    my_assert(list.head != NULL && list.head->height == SLIST_MAX_LEVEL);
+    my_assert(list.head->next[0] == NULL && slist_count(&list) == 0);
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_slist_insert()
+{
+    printf_yellow(" Testing slist_insert keeps values sorted ---> ");
+    SList list;
+    slist_init(&list, 4096);
+    uint16_t values[] = {50, 10, 40, 10, 30, 20, 60, 0};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        SNode *node = slist_insert(&list, values[i]);
+        my_assert(node != NULL && node->data == values[i]);
+        my_assert(node->height >= 1 && node->height <= SLIST_MAX_LEVEL);
+    }
+
+    uint16_t expected[] = {0, 10, 10, 20, 30, 40, 50, 60};
+    SNode *current = list.head->next[0];
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        my_assert(current->data == expected[i]);
+        current = current->next[0];
+    }
+    my_assert(current == NULL);
+    assert_slist_valid(&list);
+
+    // Equal values keep their insertion order
+    SNode *first = slist_search(&list, 10);
+    SNode *second = slist_insert(&list, 10);
+    my_assert(first->next[0]->next[0] == second);
+
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_slist_search()
+{
+    printf_yellow(" Testing slist_search and bounds ---> ");
+    SList list;
+    slist_init(&list, 4096);
+    for (int i = 1; i <= 20; i++)
+    {
+        slist_insert(&list, i * 10);
+    }
+
+    my_assert(slist_search(&list, 70)->data == 70);
+    my_assert(slist_search(&list, 75) == NULL);
+    my_assert(slist_search(&list, 0) == NULL);
+    my_assert(slist_lower_bound(&list, 75)->data == 80);
+    my_assert(slist_lower_bound(&list, 0)->data == 10);
+    my_assert(slist_lower_bound(&list, 201) == NULL);
+    my_assert(slist_last_at_most(&list, 75)->data == 70);
+    my_assert(slist_last_at_most(&list, 5) == NULL);
+    my_assert(slist_last_at_most(&list, 65535)->data == 200);
+
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_slist_delete()
+{
+    printf_yellow(" Testing slist_delete ---> ");
+    SList list;
+    slist_init(&list, 4096);
+    slist_insert(&list, 30);
+    slist_insert(&list, 10);
+    SNode *first20 = slist_insert(&list, 20);
+    SNode *second20 = slist_insert(&list, 20);
+
+    slist_delete(&list, 20); // The first of two equal values
+    my_assert(slist_search(&list, 20) == second20 && second20 != first20);
+    slist_delete(&list, 10); // The first node
+    slist_delete(&list, 30); // The last node
+    slist_delete(&list, 99); // Not in the list
+    my_assert(slist_count(&list) == 1 && list.head->next[0] == second20);
+    assert_slist_valid(&list);
+
+    slist_delete(&list, 20);
+    my_assert(slist_count(&list) == 0 && list.head->next[0] == NULL && list.level == 1);
+
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_slist_display()
+{
+    printf_yellow(" Testing slist_display and ranges ---> ");
+    SList list;
+    slist_init(&list, 4096);
+    char buffer[256];
+
+    capture_slist_display(buffer, sizeof(buffer), slist_display_range, &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[]") == 0);
+
+    slist_insert(&list, 44);
+    slist_insert(&list, 11);
+    slist_insert(&list, 33);
+    slist_insert(&list, 22);
+    capture_slist_display(buffer, sizeof(buffer), slist_display_range, &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[11, 22, 33, 44]") == 0);
+    capture_slist_display(buffer, sizeof(buffer), slist_display_range, &list, slist_search(&list, 22), slist_search(&list, 33));
+    my_assert(strcmp(buffer, "[22, 33]") == 0);
+    capture_slist_display(buffer, sizeof(buffer), slist_display_range, &list, slist_search(&list, 33), NULL);
+    my_assert(strcmp(buffer, "[33, 44]") == 0);
+
+    display_low = 12;
+    display_high = 40;
+    capture_slist_display(buffer, sizeof(buffer), display_values, &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[22, 33]") == 0);
+    display_low = 0;
+    display_high = 11;
+    capture_slist_display(buffer, sizeof(buffer), display_values, &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[11]") == 0);
+    display_low = 23;
+    display_high = 32;
+    capture_slist_display(buffer, sizeof(buffer), display_values, &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[]") == 0);
+    display_low = 45;
+    display_high = 65535;
+    capture_slist_display(buffer, sizeof(buffer), display_values, &list, NULL, NULL);
+    my_assert(strcmp(buffer, "[]") == 0);
+
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_slist_random_loop(int count)
+{
+    printf_yellow(" Testing random inserts and deletes against a sorted model ---> ");
+    SList list;
+    slist_init(&list, 64 * (size_t)count);
+    enum { DOMAIN = 1000 };
+    static uint32_t model[DOMAIN]; // number of copies of each value
+    memset(model, 0, sizeof(model));
+    size_t total = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        uint16_t value = rand() % DOMAIN;
+        if (rand() % 3 == 0)
+        {
+            slist_delete(&list, value);
+            if (model[value] > 0)
+            {
+                model[value]--;
+                total--;
+            }
+        }
+        else
+        {
+            my_assert(slist_insert(&list, value) != NULL);
+            model[value]++;
+            total++;
+        }
+    }
+    my_assert(slist_count(&list) == total);
+    assert_slist_valid(&list);
+
+    SNode *current = list.head->next[0];
+    for (uint16_t value = 0; value < DOMAIN; value++)
+    {
+        my_assert((slist_search(&list, value) != NULL) == (model[value] > 0));
+        for (uint32_t copy = 0; copy < model[value]; copy++)
+        {
+            my_assert(current->data == value);
+            current = current->next[0];
+        }
+    }
+    my_assert(current == NULL);
+
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_slist_insert_loop(int count)
+{
+    printf_yellow(" Testing slist_insert and slist_search loop ---> ");
+    SList list;
+    slist_init(&list, 64 * (size_t)count);
+    // Descending inserts would cost O(n^2) in a sorted singly linked list
+    for (int i = count - 1; i >= 0; i--)
+    {
+        my_assert(slist_insert(&list, (uint16_t)i) != NULL);
+    }
+    my_assert(slist_count(&list) == (size_t)count);
+    my_assert(list.level > 1);
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(slist_search(&list, (uint16_t)i) != NULL);
+    }
+    for (int i = 0; i < count; i++)
+    {
+        slist_delete(&list, (uint16_t)i);
+    }
+    my_assert(slist_count(&list) == 0 && list.level == 1);
+
+    slist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+  srand(time(NULL));
+#ifdef VERSION
+  printf("Build Version; %s \n", VERSION);
+#endif
+  printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_slist_init - Initialize the skip list\n");
+        printf(" 2. test_slist_insert - Test inserts keep values sorted\n");
+        printf(" 3. test_slist_search - Test search and bounds\n");
+        printf(" 4. test_slist_delete - Test delete\n");
+        printf(" 5. test_slist_display - Test the display functionality and value ranges\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 6. test_slist_random_loop - Test random inserts and deletes against a model\n");
+        printf(" 7. test_slist_insert_loop - Test multiple inserts, searches and deletes\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_slist_init();
+        test_slist_insert();
+        test_slist_search();
+        test_slist_delete();
+        test_slist_display();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_slist_random_loop(5000);
+        test_slist_insert_loop(60000);
+        break;
+    case 1:
+        test_slist_init();
+        break;
+    case 2:
+        test_slist_insert();
+        break;
+    case 3:
+        test_slist_search();
+        break;
+    case 4:
+        test_slist_delete();
+        break;
+    case 5:
+        test_slist_display();
+        break;
+    case 6:
+        test_slist_random_loop(5000);
+        break;
+    case 7:
+        test_slist_insert_loop(60000);
+        break;
+
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include "typed_list.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// A record stored inline, compared by its key only.
+typedef struct Record
+{
+    uint32_t key;
+    double weight;
+    char name[20];
+} Record;
+
+#define record_key_equals(a, b) ((a)->key == (b)->key)
+
+DEFINE_LIST(IntList, int)
+DEFINE_LIST_EQ(RecordList, Record, record_key_equals)
+
+typedef struct Pair
+{
+    uint16_t x;
+    uint16_t y;
+} Pair;
+
+DEFINE_LIST_EQ(PairList, Pair, TYPED_LIST_EQ_BYTES)
+
+// Checks the links, tail and count of an IntList against expected values.
+void assert_int_list_equals(IntList *list, const int *expected, size_t count)
+{
+    IntList_node *prev = NULL;
+    IntList_node *current = list->head;
+    for (size_t i = 0; i < count; i++)
+    {
+        my_assert(current != NULL && current->data == expected[i]);
+        prev = current;
+        current = current->next;
+    }
+    my_assert(current == NULL && list->tail == prev && IntList_length(list) == count);
+}
+
+void add_to_sum(int *value, void *ctx)
+{
+    *(long *)ctx += *value;
+}
+
+void double_weight(Record *record, void *ctx)
+{
+    (void)ctx;
+    record->weight *= 2;
+}
+
+// ********* Test basic typed list operations *********
+
+void test_tlist_basic()
+{
+    printf_yellow(" Testing DEFINE_LIST with int values ---> ");
+    mem_init(sizeof(IntList_node) * 8);
+    IntList list;
+    IntList_init(&list, NULL);
+    my_assert(IntList_find(&list, 1) == NULL && !IntList_remove(&list, 1));
+    assert_int_list_equals(&list, NULL, 0);
+
+    IntList_node *two = IntList_append(&list, 2);
+    IntList_prepend(&list, 1);
+    IntList_node *four = IntList_append(&list, 4);
+    IntList_add_before(&list, four, 3);
+    IntList_add_after(&list, four, 5);
+    IntList_add_before(&list, list.head, 0);
+    int expected[] = {0, 1, 2, 3, 4, 5};
+    assert_int_list_equals(&list, expected, 6);
+    my_assert(IntList_find(&list, 2) == two && IntList_find(&list, -2) == NULL);
+
+    long sum = 0;
+    IntList_for_each(&list, add_to_sum, &sum);
+    my_assert(sum == 15);
+
+    // Head, middle and tail
+    my_assert(IntList_remove(&list, 0) && IntList_remove(&list, 3) && IntList_remove(&list, 5));
+    int afterRemove[] = {1, 2, 4};
+    assert_int_list_equals(&list, afterRemove, 3);
+    IntList_remove_node(&list, list.tail);
+    IntList_append(&list, 6);
+    int afterTail[] = {1, 2, 6};
+    assert_int_list_equals(&list, afterTail, 3);
+
+    // Nodes come from the pool
+    for (int i = 0; i < 5; i++)
+    {
+        my_assert(IntList_append(&list, i) != NULL);
+    }
+    my_assert(IntList_append(&list, 9) == NULL && IntList_length(&list) == 8);
+    my_assert(IntList_add_after(&list, NULL, 9) == NULL);
+    IntList_destroy(&list);
+    my_assert(list.head == NULL && list.tail == NULL && IntList_length(&list) == 0);
+    my_assert(mem_alloc(sizeof(IntList_node) * 8) != NULL);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_tlist_records()
+{
+    printf_yellow(" Testing DEFINE_LIST_EQ with inline records ---> ");
+    MemPool *pool = mem_pool_create(sizeof(RecordList_node) * 4);
+    my_assert(pool != NULL);
+    RecordList list;
+    RecordList_init(&list, pool);
+    my_assert(sizeof(RecordList_node) == sizeof(void *) + sizeof(Record));
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        Record record = {i * 10, i + 0.5, ""};
+        snprintf(record.name, sizeof(record.name), "record %u", i);
+        RecordList_node *node = RecordList_append(&list, record);
+        my_assert(node != NULL && (char *)&node->data == (char *)node + sizeof(void *));
+    }
+
+    // Only the key takes part in comparisons
+    Record probe = {20, -1, "other"};
+    RecordList_node *found = RecordList_find(&list, probe);
+    my_assert(found != NULL && strcmp(found->data.name, "record 2") == 0 && found->data.weight == 2.5);
+    RecordList_for_each(&list, double_weight, NULL);
+    my_assert(found->data.weight == 5.0 && list.head->data.weight == 1.0);
+    my_assert(RecordList_remove(&list, probe) && RecordList_find(&list, probe) == NULL);
+    my_assert(RecordList_length(&list) == 3 && list.tail->data.key == 30);
+
+    // Inline comparison of all bytes
+    PairList pairs;
+    MemPool *pairPool = mem_pool_create(sizeof(PairList_node) * 3);
+    PairList_init(&pairs, pairPool);
+    PairList_append(&pairs, (Pair){1, 2});
+    PairList_append(&pairs, (Pair){2, 1});
+    PairList_append(&pairs, (Pair){1, 2});
+    my_assert(PairList_find(&pairs, (Pair){2, 1}) == pairs.head->next);
+    my_assert(PairList_remove(&pairs, (Pair){1, 2}) && pairs.head->data.x == 2);
+    my_assert(PairList_find(&pairs, (Pair){2, 2}) == NULL);
+
+    // Destroying the pools releases every node at once
+    mem_pool_destroy(pool);
+    mem_pool_destroy(pairPool);
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_tlist_loop(int count)
+{
+    printf_yellow(" Testing many typed list appends, finds and removals ---> ");
+    MemPool *pool = mem_pool_create(sizeof(IntList_node) * count);
+    my_assert(pool != NULL);
+    IntList list;
+    IntList_init(&list, pool);
+    for (int i = 0; i < count; i++)
+    {
+        my_assert(IntList_append(&list, i * 3) != NULL);
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        int value = (rand() % count) * 3;
+        IntList_node *node = IntList_find(&list, value);
+        if (node == NULL)
+            continue;
+        my_assert(node->data == value);
+        my_assert(IntList_remove(&list, value) && IntList_find(&list, value) == NULL);
+        my_assert(IntList_append(&list, value) == list.tail);
+    }
+    my_assert(IntList_length(&list) == (size_t)count);
+    long sum = 0;
+    IntList_for_each(&list, add_to_sum, &sum);
+    my_assert(sum == 3L * count * (count - 1) / 2);
+    IntList_destroy(&list);
+    mem_pool_destroy(pool);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+  srand(time(NULL));
+#ifdef VERSION
+  printf("Build Version; %s \n", VERSION);
+#endif
+  printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_tlist_basic - Test DEFINE_LIST with int values\n");
+        printf(" 2. test_tlist_records - Test DEFINE_LIST_EQ with inline records\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 3. test_tlist_loop - Test multiple appends, finds and removals\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+      printf("No tests will be executed.\n");
+      break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_tlist_basic();
+        test_tlist_records();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_tlist_loop(20000);
+        break;
+    case 1:
+        test_tlist_basic();
+        break;
+    case 2:
+        test_tlist_records();
+        break;
+    case 3:
+        test_tlist_loop(20000);
+        break;
+
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,475 @@
+#include "unrolled_list.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// Function to capture the output of a display function.
+void capture_ulist_display(char *buffer, size_t size, UList *list, UListPos startPos, UListPos endPos, bool full)
+{
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    if (fp == NULL)
+    {
+        printf("Failed to open temporary file for capturing stdout.\n");
+        return;
+    }
+
+    stdout = fp;
+    if (full)
+        ulist_display(list);
+    else
+        ulist_display_range(list, startPos, endPos);
+    fflush(fp);
+    rewind(fp);
+
+    size_t length = fread(buffer, 1, size - 1, fp);
+    buffer[length] = '\0';
+
+    fclose(fp);
+    stdout = original_stdout;
+}
+
+// Checks that the list holds exactly the given values, in order.
+void assert_ulist_equals(UList *list, const int *values, size_t count)
+{
+    size_t seen = 0;
+    for (UNode *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(node->count > 0 && node->count <= ULIST_CAPACITY);
+        for (size_t i = 0; i < node->count; i++)
+        {
+            my_assert(seen < count);
+            my_assert(node->values[i] == values[seen]);
+            seen++;
+        }
+        if (node->next == NULL)
+            my_assert(list->tail == node);
+    }
+    my_assert(seen == count);
+    my_assert(ulist_count(list) == count);
+}
+
+// ********* Test basic unrolled list operations *********
+
+void test_ulist_init()
+{
+    printf_yellow(" Testing ulist_init ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode));
+    my_assert(list.head == NULL && list.tail == NULL);
+    my_assert(ulist_count(&list) == 0);
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_insert()
+{
+    printf_yellow(" Testing ulist_insert ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 2);
+
+    int values[ULIST_CAPACITY + 1];
+    for (size_t i = 0; i < ULIST_CAPACITY + 1; i++)
+    {
+        values[i] = 100 + i;
+        ulist_insert(&list, values[i]);
+    }
+    my_assert(list.head->count == ULIST_CAPACITY); // The first node is filled completely
+    my_assert(list.tail->count == 1);
+    assert_ulist_equals(&list, values, ULIST_CAPACITY + 1);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_insert_after()
+{
+    printf_yellow(" Testing ulist_insert_after ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 2);
+
+    int values[ULIST_CAPACITY + 1];
+    for (size_t i = 0; i < ULIST_CAPACITY; i++)
+    {
+        ulist_insert(&list, i);
+    }
+
+    // The node is full, so inserting in its middle splits it
+    UListPos pos = ulist_search(&list, 3);
+    UListPos added = ulist_insert_after(&list, pos, 1000);
+    my_assert(added.node != NULL && ulist_get(added) == 1000);
+    my_assert(list.head != list.tail);
+
+    for (size_t i = 0, k = 0; i < ULIST_CAPACITY; i++)
+    {
+        values[k++] = i;
+        if (i == 3)
+            values[k++] = 1000;
+    }
+    assert_ulist_equals(&list, values, ULIST_CAPACITY + 1);
+
+    // Inserting after the last value of the last node
+    pos = ulist_search(&list, ULIST_CAPACITY - 1);
+    added = ulist_insert_after(&list, pos, 2000);
+    my_assert(list.tail == added.node && ulist_get(added) == 2000);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_delete()
+{
+    printf_yellow(" Testing ulist_delete ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 2);
+
+    int values[ULIST_CAPACITY + 2];
+    for (size_t i = 0; i < ULIST_CAPACITY + 2; i++)
+    {
+        values[i] = i;
+        ulist_insert(&list, i);
+    }
+
+    // Shrinking the first node below half full merges the second into it
+    size_t deleted = ULIST_CAPACITY - ULIST_CAPACITY / 2 + 1;
+    for (size_t i = 0; i < deleted; i++)
+    {
+        ulist_delete(&list, i);
+    }
+    my_assert(list.head == list.tail);
+    assert_ulist_equals(&list, values + deleted, ULIST_CAPACITY + 2 - deleted);
+
+    ulist_delete(&list, 12345); // Not in the list
+    for (size_t i = deleted; i < ULIST_CAPACITY + 2; i++)
+    {
+        ulist_delete(&list, i);
+    }
+    my_assert(list.head == NULL && list.tail == NULL);
+    my_assert(ulist_count(&list) == 0);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_search()
+{
+    printf_yellow(" Testing ulist_search ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 2);
+    for (size_t i = 0; i < ULIST_CAPACITY + 5; i++)
+    {
+        ulist_insert(&list, i % 7);
+    }
+
+    UListPos found = ulist_search(&list, 4);
+    my_assert(found.node == list.head && found.index == 4); // First occurrence
+    my_assert(ulist_get(found) == 4);
+
+    UListPos not_found = ulist_search(&list, 30);
+    my_assert(not_found.node == NULL);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_display()
+{
+    printf_yellow(" Testing ulist_display ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 3);
+    char buffer[1024];
+    UListPos none = {NULL, 0};
+
+    capture_ulist_display(buffer, sizeof(buffer), &list, none, none, true);
+    my_assert(strcmp(buffer, "NULL") == 0);
+    capture_ulist_display(buffer, sizeof(buffer), &list, none, none, false);
+    my_assert(strcmp(buffer, "[]") == 0);
+
+    char expected[1024] = "[";
+    for (size_t i = 0; i < ULIST_CAPACITY + 3; i++)
+    {
+        ulist_insert(&list, 10 + i);
+        sprintf(expected + strlen(expected), i ? ", %d" : "%d", (int)(10 + i));
+    }
+    strcat(expected, "]");
+
+    capture_ulist_display(buffer, sizeof(buffer), &list, none, none, true);
+    my_assert(strcmp(buffer, expected) == 0);
+
+    // A range that crosses from the first node into the second
+    UListPos from = ulist_search(&list, 10 + ULIST_CAPACITY - 2);
+    UListPos to = ulist_search(&list, 10 + ULIST_CAPACITY + 1);
+    capture_ulist_display(buffer, sizeof(buffer), &list, from, to, false);
+    sprintf(expected, "[%d, %d, %d, %d]", (int)(10 + ULIST_CAPACITY - 2), (int)(10 + ULIST_CAPACITY - 1),
+            (int)(10 + ULIST_CAPACITY), (int)(10 + ULIST_CAPACITY + 1));
+    my_assert(strcmp(buffer, expected) == 0);
+    printf("%s ", buffer);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_u16_find()
+{
+    printf_yellow(" Testing u16_find (%s) against the scalar search ---> ", u16_search_variant());
+    uint16_t values[80];
+    for (size_t n = 0; n <= 72; n++)
+    {
+        for (size_t offset = 0; offset < 3; offset++)
+        {
+            uint16_t *base = values + offset;
+            for (size_t i = 0; i < n; i++)
+            {
+                base[i] = (uint16_t)(1000 + i);
+            }
+            my_assert(u16_find(base, n, 7) == n);
+            for (size_t pos = 0; pos < n; pos++)
+            {
+                // A match at pos, and a later duplicate that must not win
+                base[pos] = 7;
+                if (pos + 3 < n) base[pos + 3] = 7;
+                my_assert(u16_find(base, n, 7) == pos);
+                my_assert(u16_find_scalar(base, n, 7) == pos);
+                base[pos] = (uint16_t)(1000 + pos);
+                if (pos + 3 < n) base[pos + 3] = (uint16_t)(1003 + pos);
+            }
+            // Values that only differ in one byte of the key do not match
+            if (n > 0)
+            {
+                base[n - 1] = 0x0700;
+                my_assert(u16_find(base, n, 7) == n);
+                base[n - 1] = 0xFFFF;
+                my_assert(u16_find(base, n, 0xFFFF) == n - 1);
+            }
+        }
+    }
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_find_all()
+{
+    printf_yellow(" Testing ulist_find_all ---> ");
+    UList list;
+    size_t count = ULIST_CAPACITY * 5;
+    ulist_init(&list, sizeof(UNode) * 8);
+    for (size_t i = 0; i < count; i++)
+    {
+        ulist_insert(&list, i % 5 == 0 ? 42 : (uint16_t)(1000 + i));
+    }
+
+    UListPos positions[ULIST_CAPACITY * 5];
+    size_t found = ulist_find_all(&list, 42, positions, count);
+    my_assert(found == (count + 4) / 5);
+    for (size_t i = 0; i < found; i++)
+    {
+        my_assert(ulist_get(positions[i]) == 42);
+    }
+    my_assert(positions[0].node == list.head && positions[0].index == 0);
+
+    // Positions come back in list order
+    size_t seen = 0;
+    for (UNode *node = list.head; node != NULL; node = node->next)
+    {
+        for (size_t index = 0; index < node->count; index++)
+        {
+            if (node->values[index] != 42) continue;
+            my_assert(positions[seen].node == node && positions[seen].index == index);
+            seen++;
+        }
+    }
+    my_assert(seen == found);
+
+    // A short buffer still reports the total
+    my_assert(ulist_find_all(&list, 42, positions, 3) == found);
+    my_assert(ulist_find_all(&list, 42, NULL, 0) == found);
+    my_assert(ulist_find_all(&list, 7, positions, count) == 0);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* Stress and edge cases *********
+
+void test_ulist_insert_loop(int count)
+{
+    printf_yellow(" Testing ulist_insert loop ---> ");
+    UList list;
+    // A Node per value would need 16 bytes each; full nodes need 64 per ULIST_CAPACITY
+    ulist_init(&list, sizeof(UNode) * ((count + ULIST_CAPACITY - 1) / ULIST_CAPACITY));
+    for (int i = 0; i < count; i++)
+    {
+        ulist_insert(&list, i);
+    }
+    my_assert(ulist_count(&list) == (size_t)count);
+
+    int i = 0;
+    for (UNode *node = list.head; node != NULL; node = node->next)
+    {
+        for (size_t k = 0; k < node->count; k++)
+        {
+            my_assert(node->values[k] == i++);
+        }
+    }
+    my_assert(i == count);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_insert_after_loop(int count)
+{
+    printf_yellow(" Testing ulist_insert_after loop ---> ");
+    UList list;
+    // Splits leave nodes half full
+    ulist_init(&list, sizeof(UNode) * (2 * count / ULIST_CAPACITY + 2));
+    ulist_insert(&list, 12345);
+
+    for (int i = 0; i < count; i++)
+    {
+        UListPos pos = ulist_search(&list, 12345);
+        my_assert(ulist_insert_after(&list, pos, i).node != NULL);
+    }
+
+    UListPos pos = ulist_search(&list, 12345);
+    my_assert(pos.node == list.head && pos.index == 0);
+    int expected = count - 1;
+    for (UNode *node = list.head; node != NULL; node = node->next)
+    {
+        for (size_t k = (node == list.head) ? 1 : 0; k < node->count; k++)
+        {
+            my_assert(node->values[k] == expected--);
+        }
+    }
+    my_assert(expected == -1);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_delete_loop(int count)
+{
+    printf_yellow(" Testing ulist_delete loop ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * ((count + ULIST_CAPACITY - 1) / ULIST_CAPACITY));
+    for (int i = 0; i < count; i++)
+    {
+        ulist_insert(&list, i);
+    }
+
+    // Delete every other value, then the rest
+    for (int i = 0; i < count; i += 2)
+    {
+        ulist_delete(&list, i);
+    }
+    my_assert(ulist_count(&list) == (size_t)count / 2);
+    for (int i = 1; i < count; i += 2)
+    {
+        my_assert(ulist_search(&list, i).node != NULL);
+        ulist_delete(&list, i);
+    }
+    my_assert(list.head == NULL);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+  srand(time(NULL));
+#ifdef VERSION
+  printf("Build Version; %s \n", VERSION);
+#endif
+  printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_ulist_init - Initialize the unrolled list\n");
+        printf(" 2. test_ulist_insert - Test appending values across nodes\n");
+        printf(" 3. test_ulist_insert_after - Test insert after a position, splitting full nodes\n");
+        printf(" 4. test_ulist_delete - Test delete, merging and freeing nodes\n");
+        printf(" 5. test_ulist_search - Test search for a particular value\n");
+        printf(" 6. test_ulist_display - Test the display functionality\n");
+
+        printf("\nStress and Edge Cases:\n");
+        printf(" 7. test_ulist_insert_loop - Test multiple insertions\n");
+        printf(" 8. test_ulist_insert_after_loop - Test multiple insertions after a given position\n");
+        printf(" 9. test_ulist_delete_loop - Test multiple deletions\n");
+
+        printf("\nVectorized Search:\n");
+        printf("10. test_u16_find - Test the vector search kernel against the scalar one\n");
+        printf("11. test_ulist_find_all - Test finding every occurrence of a value\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_ulist_init();
+        test_ulist_insert();
+        test_ulist_insert_after();
+        test_ulist_delete();
+        test_ulist_search();
+        test_ulist_display();
+
+        printf("\nTesting Stress and Edge Cases:\n");
+        test_ulist_insert_loop(1000);
+        test_ulist_insert_after_loop(1000);
+        test_ulist_delete_loop(1000);
+
+        printf("\nTesting Vectorized Search:\n");
+        test_u16_find();
+        test_ulist_find_all();
+        break;
+    case 1:
+        test_ulist_init();
+        break;
+    case 2:
+        test_ulist_insert();
+        break;
+    case 3:
+        test_ulist_insert_after();
+        break;
+    case 4:
+        test_ulist_delete();
+        break;
+    case 5:
+        test_ulist_search();
+        break;
+    case 6:
+        test_ulist_display();
+        break;
+    case 7:
+        test_ulist_insert_loop(1000);
+        break;
+    case 8:
+        test_ulist_insert_after_loop(1000);
+        break;
+    case 9:
+        test_ulist_delete_loop(1000);
+        break;
+    case 10:
+        test_u16_find();
+        break;
+    case 11:
+        test_ulist_find_all();
+        break;
+
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
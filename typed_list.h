@@ -0,0 +1,187 @@
+#ifndef TYPED_LIST_H
+#define TYPED_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "memory_manager.h"
+
+// Generates a singly linked list of values of any type, stored inline in the
+// nodes, with its nodes taken from a pool:
+//
+//   DEFINE_LIST(IntList, int)
+//   DEFINE_LIST_EQ(PointList, Point, point_equals)
+//
+// declares the types IntList and IntList_node and static inline functions
+// IntList_init, IntList_append, IntList_prepend, IntList_add_after,
+// IntList_add_before, IntList_find, IntList_remove, IntList_remove_node,
+// IntList_for_each, IntList_length and IntList_destroy. Values are passed and
+// copied by value.
+//
+// eq(a, b) decides whether the values a and b point to are equal, for find and
+// remove. It may be a function or a macro, so the comparison is inlined.
+// DEFINE_LIST compares with ==, which only works for scalar types; records
+// need DEFINE_LIST_EQ, for example with TYPED_LIST_EQ_BYTES.
+
+// Equality of scalar values.
+#define TYPED_LIST_EQ_VALUE(a, b) (*(a) == *(b))
+// Equality of all bytes of two values, for records without padding.
+#define TYPED_LIST_EQ_BYTES(a, b) (memcmp((a), (b), sizeof(*(a))) == 0)
+
+#define DEFINE_LIST(name, type) DEFINE_LIST_EQ(name, type, TYPED_LIST_EQ_VALUE)
+
+#define DEFINE_LIST_EQ(name, type, eq)                                                              \
+    typedef struct name##_node {                                                                    \
+        struct name##_node* next; /* A pointer to the next node in the list */                      \
+        type data;                /* The value, stored in the node itself */                        \
+    } name##_node;                                                                                  \
+                                                                                                    \
+    typedef struct name {                                                                           \
+        name##_node* head; /* first node, NULL when the list is empty */                            \
+        name##_node* tail; /* last node, NULL when the list is empty */                             \
+        size_t count;      /* number of nodes */                                                    \
+        MemPool* pool;     /* pool of the nodes, NULL for the default pool */                       \
+    } name;                                                                                         \
+                                                                                                    \
+    /* Initializes an empty list whose nodes come from pool, NULL for the default pool. */          \
+    static inline void name##_init(name* list, MemPool* pool) {                                     \
+        list->head = NULL;                                                                          \
+        list->tail = NULL;                                                                          \
+        list->count = 0;                                                                            \
+        list->pool = pool;                                                                          \
+    }                                                                                               \
+                                                                                                    \
+    /* Allocates a node holding value, or returns NULL if the pool is full. */                      \
+    static inline name##_node* name##_node_new(name* list, type value) {                            \
+        name##_node* node = (name##_node*)mem_pool_alloc(list->pool, sizeof(name##_node));          \
+        if (node == NULL) {                                                                         \
+            printf_red("%s,%d Memory allocation failed in mem_pool_alloc()\n", __FILE__, __LINE__); \
+            return NULL;                                                                            \
+        }                                                                                           \
+        node->data = value;                                                                         \
+        node->next = NULL;                                                                          \
+        list->count++;                                                                              \
+        return node;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Inserts value at the end of the list in constant time. Returns its node, or NULL. */         \
+    static inline name##_node* name##_append(name* list, type value) {                              \
+        name##_node* node = name##_node_new(list, value);                                           \
+        if (node == NULL) return NULL;                                                              \
+        if (list->tail != NULL) {                                                                   \
+            list->tail->next = node;                                                                \
+        } else {                                                                                    \
+            list->head = node;                                                                      \
+        }                                                                                           \
+        list->tail = node;                                                                          \
+        return node;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Inserts value at the start of the list. Returns its node, or NULL. */                        \
+    static inline name##_node* name##_prepend(name* list, type value) {                             \
+        name##_node* node = name##_node_new(list, value);                                           \
+        if (node == NULL) return NULL;                                                              \
+        node->next = list->head;                                                                    \
+        list->head = node;                                                                          \
+        if (list->tail == NULL) list->tail = node;                                                  \
+        return node;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Inserts value after prevNode. Returns its node, or NULL. */                                  \
+    static inline name##_node* name##_add_after(name* list, name##_node* prevNode, type value) {    \
+        if (prevNode == NULL) {                                                                     \
+            printf_red("Previous node cannot be NULL\n");                                           \
+            return NULL;                                                                            \
+        }                                                                                           \
+        name##_node* node = name##_node_new(list, value);                                           \
+        if (node == NULL) return NULL;                                                              \
+        node->next = prevNode->next;                                                                \
+        prevNode->next = node;                                                                      \
+        if (list->tail == prevNode) list->tail = node;                                              \
+        return node;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Inserts value before nextNode, found from the head. Returns its node, or NULL. */            \
+    static inline name##_node* name##_add_before(name* list, name##_node* nextNode, type value) {   \
+        if (nextNode == NULL) {                                                                     \
+            printf_red("Next node cannot be NULL\n");                                               \
+            return NULL;                                                                            \
+        }                                                                                           \
+        name##_node** link = &list->head;                                                           \
+        while (*link != NULL && *link != nextNode) link = &(*link)->next;                           \
+        if (*link == NULL) return NULL;                                                             \
+        name##_node* node = name##_node_new(list, value);                                           \
+        if (node == NULL) return NULL;                                                              \
+        node->next = nextNode;                                                                      \
+        *link = node;                                                                               \
+        return node;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Returns the first node whose value equals value, or NULL. */                                 \
+    static inline name##_node* name##_find(name* list, type value) {                                \
+        name##_node* current = list->head;                                                          \
+        while (current != NULL && !(eq(&current->data, &value))) current = current->next;           \
+        return current;                                                                             \
+    }                                                                                               \
+                                                                                                    \
+    /* Unlinks the node at *link and returns it to the pool. */                                     \
+    static inline void name##_unlink(name* list, name##_node** link, name##_node* prev) {           \
+        name##_node* node = *link;                                                                  \
+        *link = node->next;                                                                         \
+        if (list->tail == node) list->tail = prev;                                                  \
+        list->count--;                                                                              \
+        mem_pool_free(list->pool, node);                                                            \
+    }                                                                                               \
+                                                                                                    \
+    /* Removes the first node whose value equals value. Returns false if there is none. */          \
+    static inline bool name##_remove(name* list, type value) {                                      \
+        name##_node** link = &list->head;                                                           \
+        name##_node* prev = NULL;                                                                   \
+        while (*link != NULL && !(eq(&(*link)->data, &value))) {                                    \
+            prev = *link;                                                                           \
+            link = &(*link)->next;                                                                  \
+        }                                                                                           \
+        if (*link == NULL) return false;                                                            \
+        name##_unlink(list, link, prev);                                                            \
+        return true;                                                                                \
+    }                                                                                               \
+                                                                                                    \
+    /* Removes a node of the list, which is looked up from the head. */                             \
+    static inline void name##_remove_node(name* list, name##_node* node) {                          \
+        name##_node** link = &list->head;                                                           \
+        name##_node* prev = NULL;                                                                   \
+        while (*link != NULL && *link != node) {                                                    \
+            prev = *link;                                                                           \
+            link = &(*link)->next;                                                                  \
+        }                                                                                           \
+        if (*link != NULL) name##_unlink(list, link, prev);                                         \
+    }                                                                                               \
+                                                                                                    \
+    /* Calls fn with a pointer to every value, first to last. fn may change values, not links. */   \
+    static inline void name##_for_each(name* list, void (*fn)(type*, void*), void* ctx) {           \
+        for (name##_node* current = list->head; current != NULL; current = current->next) {         \
+            fn(&current->data, ctx);                                                                \
+        }                                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    /* Returns the number of nodes in constant time. */                                             \
+    static inline size_t name##_length(name* list) {                                                \
+        return list->count;                                                                         \
+    }                                                                                               \
+                                                                                                    \
+    /* Returns all nodes to the pool and leaves the list empty. */                                  \
+    static inline void name##_destroy(name* list) {                                                 \
+        name##_node* current = list->head;                                                          \
+        while (current != NULL) {                                                                   \
+            name##_node* next = current->next;                                                      \
+            mem_pool_free(list->pool, current);                                                     \
+            current = next;                                                                         \
+        }                                                                                           \
+        list->head = NULL;                                                                          \
+        list->tail = NULL;                                                                          \
+        list->count = 0;                                                                            \
+    }
+
+#endif
@@ -0,0 +1,128 @@
+#include "u16_search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define U16_SEARCH_X86 1
+#endif
+
+typedef size_t (*U16FindFn)(const uint16_t *values, size_t n, uint16_t key);
+
+/**
+ * Finds the first occurrence of a value, comparing one value at a time.
+ *
+ * @param values The values to search.
+ * @param n The number of values.
+ * @param key The value to search for.
+ * @return The index of the first match, or n if there is none.
+ */
+size_t u16_find_scalar(const uint16_t *values, size_t n, uint16_t key) {
+    for (size_t i = 0; i < n; i++) {
+        if (values[i] == key) return i;
+    }
+    return n;
+}
+
+#ifdef U16_SEARCH_X86
+/// @brief SSE2 kernel: 8 values per compare, 16 per loop iteration
+/// @param values
+/// @param n
+/// @param key
+/// @return the index of the first match, or n
+__attribute__((target("sse2")))
+static size_t u16_find_sse2(const uint16_t *values, size_t n, uint16_t key) {
+    const __m128i needle = _mm_set1_epi16((short)key);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(values + i)), needle);
+        __m128i b = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(values + i + 8)), needle);
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_packs_epi16(a, b));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    if (i + 8 <= n) {
+        __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(values + i)), needle);
+        unsigned mask = (unsigned)_mm_movemask_epi8(a);
+        if (mask != 0) return i + __builtin_ctz(mask) / 2;
+        i += 8;
+    }
+    for (; i < n; i++) {
+        if (values[i] == key) return i;
+    }
+    return n;
+}
+
+/// @brief AVX2 kernel: 16 values per compare, 32 per loop iteration
+/// @param values
+/// @param n
+/// @param key
+/// @return the index of the first match, or n
+__attribute__((target("avx2")))
+static size_t u16_find_avx2(const uint16_t *values, size_t n, uint16_t key) {
+    const __m256i needle = _mm256_set1_epi16((short)key);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(values + i)), needle);
+        __m256i b = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(values + i + 16)), needle);
+        // packs works per 128-bit lane; the permute puts the values back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(packed);
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    if (i + 16 <= n) {
+        __m256i a = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(values + i)), needle);
+        unsigned mask = (unsigned)_mm256_movemask_epi8(a);
+        if (mask != 0) return i + __builtin_ctz(mask) / 2;
+        i += 16;
+    }
+    return i + u16_find_sse2(values + i, n - i, key);
+}
+#endif
+
+/// @brief picks the widest kernel the CPU supports
+/// @return the kernel
+static U16FindFn u16_find_select() {
+#ifdef U16_SEARCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return u16_find_avx2;
+    if (__builtin_cpu_supports("sse2")) return u16_find_sse2;
+#endif
+    return u16_find_scalar;
+}
+
+// Selected on the first call. Racing first calls store the same value.
+static U16FindFn u16FindImpl = NULL;
+
+/// @brief returns the selected kernel, selecting it on the first call
+static U16FindFn u16_find_impl() {
+    U16FindFn fn = __atomic_load_n(&u16FindImpl, __ATOMIC_RELAXED);
+    if (fn == NULL) {
+        fn = u16_find_select();
+        __atomic_store_n(&u16FindImpl, fn, __ATOMIC_RELAXED);
+    }
+    return fn;
+}
+
+/**
+ * Finds the first occurrence of a value with the widest vector kernel the
+ * CPU supports.
+ *
+ * @param values The values to search.
+ * @param n The number of values.
+ * @param key The value to search for.
+ * @return The index of the first match, or n if there is none.
+ */
+size_t u16_find(const uint16_t *values, size_t n, uint16_t key) {
+    return u16_find_impl()(values, n, key);
+}
+
+/**
+ * Returns the name of the kernel u16_find uses: "avx2", "sse2" or "scalar".
+ */
+const char *u16_search_variant(void) {
+    U16FindFn fn = u16_find_impl();
+#ifdef U16_SEARCH_X86
+    if (fn == u16_find_avx2) return "avx2";
+    if (fn == u16_find_sse2) return "sse2";
+#endif
+    (void)fn;
+    return "scalar";
+}
@@ -0,0 +1,15 @@
+#ifndef U16_SEARCH_H
+#define U16_SEARCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Searches contiguous uint16_t values, comparing 16 values per instruction
+// with AVX2 or 8 with SSE2 where the CPU has them, and one at a time
+// otherwise. The variant is picked once, on the first call.
+
+size_t u16_find(const uint16_t* values, size_t n, uint16_t key);
+size_t u16_find_scalar(const uint16_t* values, size_t n, uint16_t key);
+const char* u16_search_variant(void);
+
+#endif
@@ -0,0 +1,279 @@
+#include "unrolled_list.h"
+
+/// @brief allocates an empty node
+/// @return the new node, or NULL if the pool is full
+static UNode *unode_new() {
+    UNode *node = (UNode *)mem_alloc(sizeof(UNode));
+    if (node == NULL) {
+        printf_red("%s,%d Memory allocation failed in mem_alloc()\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    node->next = NULL;
+    node->count = 0;
+    return node;
+}
+
+/// @brief moves the upper half of a full node into a new node after it
+/// @param list
+/// @param node
+/// @return the new node, or NULL if the pool is full
+static UNode *unode_split(UList *list, UNode *node) {
+    UNode *split = unode_new();
+    if (split == NULL) return NULL;
+
+    size_t half = node->count / 2;
+    split->count = node->count - half;
+    memcpy(split->values, node->values + half, split->count * sizeof(uint16_t));
+    node->count = half;
+
+    split->next = node->next;
+    node->next = split;
+    if (list->tail == node) list->tail = split;
+    return split;
+}
+
+/**
+ * Initializes the unrolled list.
+ *
+ * @param list The list to initialize.
+ * @param size The size of the memory pool the nodes are taken from.
+ */
+void ulist_init(UList *list, size_t size) {
+    mem_init(size);
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+}
+
+/**
+ * Inserts a value at the end of the list. The last node is filled completely
+ * before a new one is started.
+ *
+ * @param list The list.
+ * @param data The data to be inserted.
+ */
+void ulist_insert(UList *list, uint16_t data) {
+    UNode *tail = list->tail;
+    if (tail == NULL || tail->count == ULIST_CAPACITY) {
+        UNode *newNode = unode_new();
+        if (newNode == NULL) return;
+        if (tail == NULL) {
+            list->head = newNode;
+        } else {
+            tail->next = newNode;
+        }
+        list->tail = tail = newNode;
+    }
+    tail->values[tail->count++] = data;
+    list->count++;
+}
+
+/**
+ * Inserts a value after a given position. A full node is split in two first.
+ * Positions of values after the new one are invalidated.
+ *
+ * @param list The list.
+ * @param prevPos The position after which the value will be inserted.
+ * @param data The data to be inserted.
+ * @return The position of the new value, or a position with a NULL node if
+ * the insertion failed.
+ */
+UListPos ulist_insert_after(UList *list, UListPos prevPos, uint16_t data) {
+    UListPos pos = {NULL, 0};
+    if (prevPos.node == NULL || prevPos.index >= prevPos.node->count) {
+        printf_red("Previous position must refer to a value\n");
+        return pos;
+    }
+
+    UNode *node = prevPos.node;
+    size_t index = prevPos.index + 1;
+    if (node->count == ULIST_CAPACITY) {
+        UNode *split = unode_split(list, node);
+        if (split == NULL) return pos;
+        if (index > node->count) {
+            index -= node->count;
+            node = split;
+        }
+    }
+
+    memmove(node->values + index + 1, node->values + index, (node->count - index) * sizeof(uint16_t));
+    node->values[index] = data;
+    node->count++;
+    list->count++;
+
+    pos.node = node;
+    pos.index = index;
+    return pos;
+}
+
+/**
+ * Deletes the first occurrence of a value. A node that drops below half full
+ * is merged with the next one when their values fit in a single node, and an
+ * empty node is freed.
+ *
+ * @param list The list.
+ * @param data The data to be deleted.
+ */
+void ulist_delete(UList *list, uint16_t data) {
+    UNode *prev = NULL;
+    UNode *node = list->head;
+    size_t index = 0;
+    while (node != NULL) {
+        for (index = 0; index < node->count && node->values[index] != data; index++) {
+        }
+        if (index < node->count) break;
+        prev = node;
+        node = node->next;
+    }
+    if (node == NULL) return;
+
+    node->count--;
+    memmove(node->values + index, node->values + index + 1, (node->count - index) * sizeof(uint16_t));
+    list->count--;
+
+    if (node->count == 0) {
+        if (prev == NULL) {
+            list->head = node->next;
+        } else {
+            prev->next = node->next;
+        }
+        if (list->tail == node) list->tail = prev;
+        mem_free(node);
+        return;
+    }
+
+    UNode *next = node->next;
+    if (node->count < ULIST_CAPACITY / 2 && next != NULL && node->count + next->count <= ULIST_CAPACITY) {
+        memcpy(node->values + node->count, next->values, next->count * sizeof(uint16_t));
+        node->count += next->count;
+        node->next = next->next;
+        if (list->tail == next) list->tail = node;
+        mem_free(next);
+    }
+}
+
+/**
+ * Searches for the first occurrence of a value.
+ *
+ * @param list The list.
+ * @param data The data to search for.
+ * @return The position of the value, or a position with a NULL node if not
+ * found.
+ */
+UListPos ulist_search(UList *list, uint16_t data) {
+    for (UNode *node = list->head; node != NULL; node = node->next) {
+        size_t index = u16_find(node->values, node->count, data);
+        if (index < node->count) return (UListPos){node, index};
+    }
+    return (UListPos){NULL, 0};
+}
+
+/**
+ * Finds every occurrence of a value, in list order.
+ *
+ * @param list The list.
+ * @param data The value to search for.
+ * @param positions Receives the positions of the first max matches. May be
+ *                  NULL when max is 0.
+ * @param max The capacity of positions.
+ * @return The total number of matches, which may exceed max.
+ */
+size_t ulist_find_all(UList *list, uint16_t data, UListPos *positions, size_t max) {
+    size_t found = 0;
+    for (UNode *node = list->head; node != NULL; node = node->next) {
+        size_t index = u16_find(node->values, node->count, data);
+        while (index < node->count) {
+            if (found < max) positions[found] = (UListPos){node, index};
+            found++;
+            index++;
+            index += u16_find(node->values + index, node->count - index, data);
+        }
+    }
+    return found;
+}
+
+/**
+ * Returns the value at a position.
+ *
+ * @param pos A position that refers to a value.
+ * @return The value.
+ */
+uint16_t ulist_get(UListPos pos) {
+    return pos.node->values[pos.index];
+}
+
+/**
+ * Displays the entire list.
+ *
+ * @param list The list.
+ */
+void ulist_display(UList *list) {
+    if (list->head == NULL) {
+        printf("NULL");
+        return;
+    }
+    ulist_display_range(list, (UListPos){NULL, 0}, (UListPos){NULL, 0});
+}
+
+/**
+ * Displays a selected range of the list.
+ *
+ * @param list The list.
+ * @param startPos The first position of the range, or a NULL node to start at
+ * the head.
+ * @param endPos The last position of the range, or a NULL node to run to the
+ * end.
+ */
+void ulist_display_range(UList *list, UListPos startPos, UListPos endPos) {
+    if (list->head == NULL) {
+        printf("[]");
+        return;
+    }
+    if (startPos.node == NULL) {
+        startPos.node = list->head;
+        startPos.index = 0;
+    }
+
+    printf("[");
+    bool first = true;
+    for (UNode *node = startPos.node; node != NULL; node = node->next) {
+        size_t index = (node == startPos.node) ? startPos.index : 0;
+        for (; index < node->count; index++) {
+            printf(first ? "%d" : ", %d", node->values[index]);
+            first = false;
+            if (node == endPos.node && index == endPos.index) {
+                printf("]");
+                return;
+            }
+        }
+    }
+    printf("]");
+}
+
+/**
+ * Returns the number of values in the list.
+ *
+ * @param list The list.
+ * @return The number of values.
+ */
+size_t ulist_count(UList *list) {
+    return list->count;
+}
+
+/**
+ * Cleans up the list by freeing all nodes.
+ *
+ * @param list The list.
+ */
+void ulist_cleanup(UList *list) {
+    UNode *current = list->head;
+    while (current != NULL) {
+        UNode *next = current->next;
+        mem_free(current);
+        current = next;
+    }
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    mem_deinit();
+}
@@ -0,0 +1,47 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "common_defs.h"
+#include "memory_manager.h"
+#include "u16_search.h"
+
+// Size of one node in the pool. One cache line holds the link, the fill
+// count and as many values as fit.
+#define ULIST_NODE_BYTES 64
+#define ULIST_CAPACITY ((ULIST_NODE_BYTES - sizeof(void*) - sizeof(uint16_t)) / sizeof(uint16_t))
+
+typedef struct UNode {
+    struct UNode* next;                // A pointer to the next node in the List
+    uint16_t count;                    // Number of values in use
+    uint16_t values[ULIST_CAPACITY];   // Values in list order
+} UNode;
+
+typedef struct UList {
+    UNode* head;   // first node, NULL when the list is empty
+    UNode* tail;   // last node, NULL when the list is empty
+    size_t count;  // number of values
+} UList;
+
+// The position of one value: a node and an index into its values. A position
+// with a NULL node refers to no value.
+typedef struct UListPos {
+    UNode* node;
+    size_t index;
+} UListPos;
+
+void ulist_init(UList* list, size_t size);
+void ulist_insert(UList* list, uint16_t data);
+UListPos ulist_insert_after(UList* list, UListPos prevPos, uint16_t data);
+void ulist_delete(UList* list, uint16_t data);
+UListPos ulist_search(UList* list, uint16_t data);
+size_t ulist_find_all(UList* list, uint16_t data, UListPos* positions, size_t max);
+uint16_t ulist_get(UListPos pos);
+void ulist_display(UList* list);
+void ulist_display_range(UList* list, UListPos startPos, UListPos endPos);
+size_t ulist_count(UList* list);
+void ulist_cleanup(UList* list);
+
+#endif